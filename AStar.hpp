@@ -18,232 +18,2302 @@
 #ifndef SCU_ASTAR_001_HPP
 #define SCU_ASTAR_001_HPP
 
+#include <algorithm>
+#include <functional>
 #include <iterator>
 #include <set>
+#include <vector>
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <type_traits>
+#include <utility>
+
+#if !defined(SCU_ASTAR_SCALAR) && (defined(__SSE2__) || defined(__AVX__) || defined(_M_X64))
+#include <immintrin.h>
+#elif !defined(SCU_ASTAR_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Arena of fixed-size blocks, handing out memory from large chunks. Released blocks are kept in a
+ * free list and reused, the chunks are only returned to the system when the pool is destroyed,
+ * so a pool that has grown to its working size no longer touches the global allocator.
+ *
+ * The block size is taken from the first allocation, requests of other sizes are passed on to operator new.
+ * A pool is not thread-safe and is meant to be owned by a single search.
+ */
+class BlockPool {
+private:
+	union Block {
+		Block *next;
+		std::max_align_t align;
+	};
+	
+	std::vector<Block*> chunks {};
+	Block *free {nullptr};
+	std::size_t block {0};
+	std::size_t reserved {0};
+	std::size_t capacity {64};
+	
+	static const std::size_t blocks(std::size_t size) {
+		return (size + sizeof(Block) - 1) / sizeof(Block);
+	}
+	void grow(std::size_t count) {
+		Block *chunk = static_cast<Block*>(::operator new(count * block * sizeof(Block)));
+		chunks.push_back(chunk);
+		for(std::size_t index = count; index-- > 0;) {
+			Block *element = chunk + index * block;
+			element->next = free;
+			free = element;
+		}
+		reserved += count;
+	}
+	
+public:
+	BlockPool() {}
+	BlockPool(const BlockPool &) = delete;
+	BlockPool &operator=(const BlockPool &) = delete;
+	~BlockPool() {
+		for(auto chunk = chunks.begin(); chunk != chunks.end(); ++chunk) {
+			::operator delete(*chunk);
+		}
+	}
+	
+	/**
+	 * Makes room for at least @count blocks, allocated at once with the first block if its size is not known yet.
+	 */
+	void reserve(std::size_t count) {
+		if(block == 0) {
+			capacity = std::max(capacity, count);
+		}
+		else if(count > reserved) {
+			grow(count - reserved);
+		}
+	}
+	void *allocate(std::size_t size) {
+		if(block == 0) {
+			block = blocks(size);
+		}
+		if(blocks(size) != block) {
+			return ::operator new(size);
+		}
+		if(!free) {
+			grow(std::max(capacity, reserved));
+		}
+		Block *element = free;
+		free = element->next;
+		return element;
+	}
+	void deallocate(void *pointer, std::size_t size) {
+		if(blocks(size) != block) {
+			::operator delete(pointer);
+			return;
+		}
+		Block *element = static_cast<Block*>(pointer);
+		element->next = free;
+		free = element;
+	}
+};
+
+/**
+ * Standard allocator drawing single elements from a BlockPool, for node based containers.
+ */
+template <typename type>
+class PoolAllocator {
+	template <typename>
+	friend class PoolAllocator;
+private:
+	BlockPool *pool;
+	
+public:
+	typedef type value_type;
+	
+	template <typename other_type>
+	struct rebind {
+		typedef PoolAllocator<other_type> other;
+	};
+	
+	explicit PoolAllocator(BlockPool *pool): pool(pool) {}
+	template <typename other_type>
+	PoolAllocator(const PoolAllocator<other_type> &rhs): pool(rhs.pool) {}
+	
+	type *allocate(std::size_t count) {
+		if(count != 1) {
+			return static_cast<type*>(::operator new(count * sizeof(type)));
+		}
+		return static_cast<type*>(pool->allocate(sizeof(type)));
+	}
+	void deallocate(type *pointer, std::size_t count) {
+		if(count != 1) {
+			::operator delete(pointer);
+			return;
+		}
+		pool->deallocate(pointer, sizeof(type));
+	}
+	
+	template <typename other_type>
+	const bool operator==(const PoolAllocator<other_type> &rhs) const {
+		return pool == rhs.pool;
+	}
+	template <typename other_type>
+	const bool operator!=(const PoolAllocator<other_type> &rhs) const {
+		return pool != rhs.pool;
+	}
+};
+
+/**
+ * Open list implementations, selectable through the open_list_type template parameter of AStar.
+ *
+ * Both operate on opaque elements through an access_type object providing:
+ *   less(lhs, rhs): true if @lhs is to be expanded before @rhs
+ *   slot(element):  reference to an unsigned integer the open list may use to locate @element,
+ *                   zero meaning the element is not contained
+ *
+ * update(element) restores the order after the priority of a contained element changed, in either
+ * direction, and remove(element) takes a contained element out of the open list.
+ * reserve(count) preallocates room for @count elements, so the open list does not allocate
+ * before it grows beyond that size.
+ * for_each(visit) calls visit(element) for every contained element, in no particular order.
+ *
+ * BucketOpenList additionally calls priority(element), which returns the integral priority of @element.
+ */
+
+/**
+ * Indexed binary heap. Every element stores its heap position (offset by one) in its slot,
+ * so membership checks are O(1) and decrease-key as well as insertion and removal are O(log n).
+ */
+template <typename element_type, typename access_type>
+class BinaryHeapOpenList {
+public:
+	typedef element_type Element;
+	
+private:
+	std::vector<Element> heap {};
+	access_type access;
+	
+	void place(std::size_t index, const Element &element) {
+		heap[index] = element;
+		access.slot(element) = index + 1;
+	}
+	void up(std::size_t index) {
+		Element element = heap[index];
+		while(index > 0) {
+			std::size_t parent = (index - 1) / 2;
+			if(!access.less(element, heap[parent])) {
+				break;
+			}
+			place(index, heap[parent]);
+			index = parent;
+		}
+		place(index, element);
+	}
+	void down(std::size_t index) {
+		Element element = heap[index];
+		const std::size_t size = heap.size();
+		for(;;) {
+			std::size_t child = index * 2 + 1;
+			if(child >= size) {
+				break;
+			}
+			if(child + 1 < size && access.less(heap[child + 1], heap[child])) {
+				++child;
+			}
+			if(!access.less(heap[child], element)) {
+				break;
+			}
+			place(index, heap[child]);
+			index = child;
+		}
+		place(index, element);
+	}
+	
+public:
+	explicit BinaryHeapOpenList(const access_type &access = access_type()): access(access) {}
+	~BinaryHeapOpenList() {
+		clear();
+	}
+	
+	const bool empty() const {
+		return heap.empty();
+	}
+	const std::size_t size() const {
+		return heap.size();
+	}
+	const bool contains(const Element &element) const {
+		return access.slot(element) != 0;
+	}
+	const Element &top() const {
+		return heap.front();
+	}
+	
+	void push(const Element &element) {
+		heap.push_back(element);
+		up(heap.size() - 1);
+	}
+	Element pop() {
+		Element element = heap.front();
+		access.slot(element) = 0;
+		if(heap.size() > 1) {
+			heap.front() = heap.back();
+			heap.pop_back();
+			down(0);
+		}
+		else {
+			heap.pop_back();
+		}
+		return element;
+	}
+	/**
+	 * Restores the heap order after the priority of the contained @element changed.
+	 */
+	void update(const Element &element) {
+		up(access.slot(element) - 1);
+		down(access.slot(element) - 1);
+	}
+	void remove(const Element &element) {
+		const std::size_t index = access.slot(element) - 1;
+		access.slot(element) = 0;
+		const Element last = heap.back();
+		heap.pop_back();
+		if(index < heap.size()) {
+			place(index, last);
+			up(index);
+			down(access.slot(last) - 1);
+		}
+	}
+	void clear() {
+		for(auto element = heap.begin(); element != heap.end(); ++element) {
+			access.slot(*element) = 0;
+		}
+		heap.clear();
+	}
+	void reserve(std::size_t count) {
+		heap.reserve(count);
+	}
+	template <typename visitor_type>
+	void for_each(visitor_type &&visit) const {
+		for(auto element = heap.begin(); element != heap.end(); ++element) {
+			visit(*element);
+		}
+	}
+};
+
+/**
+ * Reference open list based on std::multiset. Decreasing an elements priority requires
+ * a linear search for the element, followed by its removal and reinsertion.
+ *
+ * The tree nodes are drawn from a BlockPool owned by the open list, so insertion and removal
+ * recycle nodes instead of calling the global allocator.
+ */
+template <typename element_type, typename access_type>
+class MultisetOpenList {
+public:
+	typedef element_type Element;
+	
+private:
+	struct Less {
+		Less(const access_type &access): access(access) {}
+		access_type access;
+		const bool operator()(const Element &lhs, const Element &rhs) const {
+			return access.less(lhs, rhs);
+		}};
+	
+	access_type access;
+	BlockPool pool {};
+	std::multiset<Element, Less, PoolAllocator<Element>> set;
+	
+public:
+	explicit MultisetOpenList(const access_type &access = access_type()):
+	access(access), set(Less(access), PoolAllocator<Element>(&pool)) {}
+	MultisetOpenList(const MultisetOpenList &) = delete;
+	MultisetOpenList &operator=(const MultisetOpenList &) = delete;
+	~MultisetOpenList() {
+		clear();
+	}
+	
+	const bool empty() const {
+		return set.empty();
+	}
+	const std::size_t size() const {
+		return set.size();
+	}
+	const bool contains(const Element &element) const {
+		return access.slot(element) != 0;
+	}
+	const Element &top() const {
+		return *set.begin();
+	}
+	
+	void push(const Element &element) {
+		access.slot(element) = 1;
+		set.insert(element);
+	}
+	Element pop() {
+		Element element = *set.begin();
+		access.slot(element) = 0;
+		set.erase(set.begin());
+		return element;
+	}
+	void update(const Element &element) {
+		set.erase(std::find(set.begin(), set.end(), element));
+		set.insert(element);
+	}
+	void remove(const Element &element) {
+		access.slot(element) = 0;
+		set.erase(std::find(set.begin(), set.end(), element));
+	}
+	void clear() {
+		for(auto element = set.begin(); element != set.end(); ++element) {
+			access.slot(*element) = 0;
+		}
+		set.clear();
+	}
+	void reserve(std::size_t count) {
+		pool.reserve(count);
+	}
+	template <typename visitor_type>
+	void for_each(visitor_type &&visit) const {
+		for(auto element = set.begin(); element != set.end(); ++element) {
+			visit(*element);
+		}
+	}
+};
+
+/**
+ * Bucket queue (Dial's algorithm) for integral priorities, such as the f values of searches with integer
+ * costs. Elements are kept in one bucket per priority, push and pop take amortised O(1) time while the
+ * priorities expanded only grow, which A* guarantees for consistent heuristics. Lower priorities are
+ * accepted as well, at the cost of moving the cursor back.
+ *
+ * Changed and removed elements are deleted lazily: every insertion stamps the element's slot, and bucket
+ * entries whose stamp no longer matches are skipped. Within a bucket the latest element comes first.
+ * Stamps have the width of the slot; when they run out, the live entries are numbered again.
+ * The buckets keep their storage between queries, so the queue stops allocating once it has seen the
+ * largest priority and bucket size of the workload.
+ */
+template <typename element_type, typename access_type>
+class BucketOpenList {
+public:
+	typedef element_type Element;
+	
+private:
+	typedef typename std::remove_reference<decltype(std::declval<const access_type &>().slot(std::declval<const Element &>()))>::type Slot;
+	
+	struct Entry {
+		Element element;
+		Slot    stamp;
+	};
+	
+	access_type access;
+	std::vector<std::vector<Entry>> buckets {};
+	std::size_t cursor {0};
+	std::size_t highest {0};
+	std::size_t count {0};
+	Slot        stamps {0};
+	
+	const std::size_t key(const Element &element) const {
+		static_assert(std::numeric_limits<decltype(access.priority(element))>::is_integer,
+					  "BucketOpenList requires integral priorities");
+		return std::size_t(access.priority(element));
+	}
+	const bool live(const Entry &entry) const {
+		return access.slot(entry.element) == entry.stamp;
+	}
+	void insert(const Element &element) {
+		const std::size_t bucket = key(element);
+		if(bucket >= buckets.size()) {
+			buckets.resize(bucket + 1);
+		}
+		if(stamps == std::numeric_limits<Slot>::max()) {
+			restamp();
+		}
+		access.slot(element) = ++stamps;
+		buckets[bucket].push_back({element, stamps});
+		cursor = std::min(cursor, bucket);
+		highest = std::max(highest, bucket);
+	}
+	/**
+	 * Drops the stale entries and numbers the live ones from 1, keeping their order.
+	 */
+	void restamp() {
+		stamps = 0;
+		for(std::size_t bucket = cursor; bucket < buckets.size() && bucket <= highest; ++bucket) {
+			std::vector<Entry> &entries = buckets[bucket];
+			std::size_t kept = 0;
+			for(auto entry = entries.begin(); entry != entries.end(); ++entry) {
+				if(live(*entry)) {
+					entries[kept].element = entry->element;
+					entries[kept].stamp = access.slot(entry->element) = ++stamps;
+					++kept;
+				}
+			}
+			entries.resize(kept);
+		}
+	}
+	/**
+	 * Drops stale entries until the last entry of the cursor bucket is the top element.
+	 */
+	void settle() {
+		while(count) {
+			std::vector<Entry> &bucket = buckets[cursor];
+			if(bucket.empty()) {
+				++cursor;
+			}
+			else if(!live(bucket.back())) {
+				bucket.pop_back();
+			}
+			else {
+				break;
+			}
+		}
+	}
+	
+public:
+	explicit BucketOpenList(const access_type &access = access_type()): access(access) {}
+	~BucketOpenList() {
+		clear();
+	}
+	
+	const bool empty() const {
+		return count == 0;
+	}
+	const std::size_t size() const {
+		return count;
+	}
+	const bool contains(const Element &element) const {
+		return access.slot(element) != 0;
+	}
+	const Element &top() const {
+		return buckets[cursor].back().element;
+	}
+	
+	void push(const Element &element) {
+		insert(element);
+		++count;
+		settle();
+	}
+	Element pop() {
+		const Element element = buckets[cursor].back().element;
+		buckets[cursor].pop_back();
+		access.slot(element) = 0;
+		--count;
+		settle();
+		return element;
+	}
+	void update(const Element &element) {
+		insert(element);
+		settle();
+	}
+	void remove(const Element &element) {
+		access.slot(element) = 0;
+		--count;
+		settle();
+	}
+	void clear() {
+		for(std::size_t bucket = cursor; bucket < buckets.size() && bucket <= highest; ++bucket) {
+			for(auto entry = buckets[bucket].begin(); entry != buckets[bucket].end(); ++entry) {
+				if(live(*entry)) {
+					access.slot(entry->element) = 0;
+				}
+			}
+			buckets[bucket].clear();
+		}
+		cursor = highest = count = 0;
+	}
+	/**
+	 * The number of buckets depends on the priorities rather than the number of elements, so the
+	 * storage is only reserved for the first bucket.
+	 */
+	void reserve(std::size_t count) {
+		if(buckets.empty()) {
+			buckets.resize(1);
+		}
+		buckets.front().reserve(count);
+	}
+	template <typename visitor_type>
+	void for_each(visitor_type &&visit) const {
+		for(std::size_t bucket = cursor; count && bucket <= highest; ++bucket) {
+			for(auto entry = buckets[bucket].begin(); entry != buckets[bucket].end(); ++entry) {
+				if(live(*entry)) {
+					visit(entry->element);
+				}
+			}
+		}
+	}
+};
+
+/**
+ * Vector of double lanes for relaxing all neighbours of a node at once: four lanes with AVX, two with
+ * SSE2 or NEON on AArch64, or a single scalar lane when the target has none of them or SCU_ASTAR_SCALAR
+ * is defined. The instruction set is the one the compiler targets, such as with -mavx.
+ *
+ * Arithmetic is exact IEEE double arithmetic in every variant, so all of them compute the same results.
+ * Comparisons return a bit mask with bit i set for lane i, NaN lanes compare false.
+ */
+struct Lanes {
+#if !defined(SCU_ASTAR_SCALAR) && defined(__AVX__)
+	typedef __m256d Vector;
+	static const unsigned int width = 4;
+	
+	static Vector load(const double *values)         { return _mm256_loadu_pd(values); }
+	static void   store(double *values, Vector lanes) { _mm256_storeu_pd(values, lanes); }
+	static Vector broadcast(double value)             { return _mm256_set1_pd(value); }
+	static Vector add(Vector lhs, Vector rhs)         { return _mm256_add_pd(lhs, rhs); }
+	static Vector sub(Vector lhs, Vector rhs)         { return _mm256_sub_pd(lhs, rhs); }
+	static Vector mul(Vector lhs, Vector rhs)         { return _mm256_mul_pd(lhs, rhs); }
+	static Vector min(Vector lhs, Vector rhs)         { return _mm256_min_pd(lhs, rhs); }
+	static Vector max(Vector lhs, Vector rhs)         { return _mm256_max_pd(lhs, rhs); }
+	static Vector abs(Vector lanes)                   { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), lanes); }
+	static const unsigned int less(Vector lhs, Vector rhs) {
+		return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_LT_OQ)));
+	}
+	static const unsigned int less_equal(Vector lhs, Vector rhs) {
+		return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_LE_OQ)));
+	}
+#elif !defined(SCU_ASTAR_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+	typedef __m128d Vector;
+	static const unsigned int width = 2;
+	
+	static Vector load(const double *values)         { return _mm_loadu_pd(values); }
+	static void   store(double *values, Vector lanes) { _mm_storeu_pd(values, lanes); }
+	static Vector broadcast(double value)             { return _mm_set1_pd(value); }
+	static Vector add(Vector lhs, Vector rhs)         { return _mm_add_pd(lhs, rhs); }
+	static Vector sub(Vector lhs, Vector rhs)         { return _mm_sub_pd(lhs, rhs); }
+	static Vector mul(Vector lhs, Vector rhs)         { return _mm_mul_pd(lhs, rhs); }
+	static Vector min(Vector lhs, Vector rhs)         { return _mm_min_pd(lhs, rhs); }
+	static Vector max(Vector lhs, Vector rhs)         { return _mm_max_pd(lhs, rhs); }
+	static Vector abs(Vector lanes)                   { return _mm_andnot_pd(_mm_set1_pd(-0.0), lanes); }
+	static const unsigned int less(Vector lhs, Vector rhs) {
+		return unsigned(_mm_movemask_pd(_mm_cmplt_pd(lhs, rhs)));
+	}
+	static const unsigned int less_equal(Vector lhs, Vector rhs) {
+		return unsigned(_mm_movemask_pd(_mm_cmple_pd(lhs, rhs)));
+	}
+#elif !defined(SCU_ASTAR_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+	typedef float64x2_t Vector;
+	static const unsigned int width = 2;
+	
+	static Vector load(const double *values)         { return vld1q_f64(values); }
+	static void   store(double *values, Vector lanes) { vst1q_f64(values, lanes); }
+	static Vector broadcast(double value)             { return vdupq_n_f64(value); }
+	static Vector add(Vector lhs, Vector rhs)         { return vaddq_f64(lhs, rhs); }
+	static Vector sub(Vector lhs, Vector rhs)         { return vsubq_f64(lhs, rhs); }
+	static Vector mul(Vector lhs, Vector rhs)         { return vmulq_f64(lhs, rhs); }
+	static Vector min(Vector lhs, Vector rhs)         { return vminq_f64(lhs, rhs); }
+	static Vector max(Vector lhs, Vector rhs)         { return vmaxq_f64(lhs, rhs); }
+	static Vector abs(Vector lanes)                   { return vabsq_f64(lanes); }
+	static const unsigned int less(Vector lhs, Vector rhs) {
+		const uint64x2_t mask = vcltq_f64(lhs, rhs);
+		return unsigned(vgetq_lane_u64(mask, 0) & 1) | unsigned(vgetq_lane_u64(mask, 1) & 1) << 1;
+	}
+	static const unsigned int less_equal(Vector lhs, Vector rhs) {
+		const uint64x2_t mask = vcleq_f64(lhs, rhs);
+		return unsigned(vgetq_lane_u64(mask, 0) & 1) | unsigned(vgetq_lane_u64(mask, 1) & 1) << 1;
+	}
+#else
+	typedef double Vector;
+	static const unsigned int width = 1;
+	
+	static Vector load(const double *values)         { return *values; }
+	static void   store(double *values, Vector lanes) { *values = lanes; }
+	static Vector broadcast(double value)             { return value; }
+	static Vector add(Vector lhs, Vector rhs)         { return lhs + rhs; }
+	static Vector sub(Vector lhs, Vector rhs)         { return lhs - rhs; }
+	static Vector mul(Vector lhs, Vector rhs)         { return lhs * rhs; }
+	static Vector min(Vector lhs, Vector rhs)         { return rhs < lhs ? rhs : lhs; }
+	static Vector max(Vector lhs, Vector rhs)         { return lhs < rhs ? rhs : lhs; }
+	static Vector abs(Vector lanes)                   { return lanes < 0 ? -lanes : lanes; }
+	static const unsigned int less(Vector lhs, Vector rhs) {
+		return lhs < rhs;
+	}
+	static const unsigned int less_equal(Vector lhs, Vector rhs) {
+		return lhs <= rhs;
+	}
+#endif
+};
+
+/**
+ * Statistics policy of AStarSearch recording nothing. Every hook is empty and inlined away,
+ * so searches without statistics run the same code as before the hooks existed.
+ *
+ * Statistics policies provide the following members, called by the search:
+ *   query():                  A query began
+ *   heuristic():              The heuristic of a node was computed
+ *   expand(id, g, f):         @id was taken from the open list to expand it
+ *   push(size):               A node was added to the open list, which then holds @size nodes
+ *   decrease():               The cost of an open node was lowered
+ *   reopen():                 A closed node was reached more cheaply and is expanded again
+ *   reject():                 A node was reached without lowering its cost
+ */
+struct NoStatistics {
+	void query() {}
+	void heuristic() {}
+	template <typename index_type, typename cost_type>
+	void expand(const index_type, const cost_type, const cost_type) {}
+	void push(const std::size_t) {}
+	void decrease() {}
+	void reopen() {}
+	void reject() {}
+};
+
+/**
+ * Statistics policy counting the work of all queries of a search until clear is called.
+ * If set, @trace is called with the id, cost and priority of every expanded node.
+ */
+struct SearchStatistics {
+	std::size_t queries {0};
+	std::size_t heuristics {0};
+	std::size_t expansions {0};
+	std::size_t pushes {0};
+	std::size_t decreases {0};
+	std::size_t reopenings {0};
+	std::size_t rejections {0};
+	std::size_t peak {0};
+	std::function<void(std::size_t, double, double)> trace {};
+	
+	void query() {
+		++queries;
+	}
+	void heuristic() {
+		++heuristics;
+	}
+	template <typename index_type, typename cost_type>
+	void expand(const index_type id, const cost_type g, const cost_type f) {
+		++expansions;
+		if(trace) {
+			trace(std::size_t(id), double(g), double(f));
+		}
+	}
+	void push(const std::size_t size) {
+		++pushes;
+		peak = std::max(peak, size);
+	}
+	void decrease() {
+		++decreases;
+	}
+	void reopen() {
+		++reopenings;
+	}
+	void reject() {
+		++rejections;
+	}
+	/**
+	 * Resets all counters, keeping the trace callback.
+	 */
+	void clear() {
+		queries = heuristics = expansions = pushes = decreases = reopenings = rejections = peak = 0;
+	}
+	/**
+	 * The largest number of bytes the open list held, for @element_size bytes per element.
+	 */
+	const std::size_t peak_memory(std::size_t element_size) const {
+		return peak * element_size;
+	}
+};
+
+/**
+ * Graph-independent A* search over dense node ids, the core loop shared by AStar and the specialized
+ * search engines built on it.
+ *
+ * The graph is treated as read-only: all per-search data (costs, predecessors, open and closed state)
+ * is held in a contiguous State array indexed by node id and owned by the search, so any number of
+ * searches may run concurrently on the same graph.
+ *
+ * A search object is reusable: each query reuses the storage of the previous ones and resets the
+ * per-node data lazily, so repeated queries do not allocate once the open list has grown to its
+ * working size.
+ *
+ * Template parameters:
+ *   graph_type:     Type providing the following members:
+ *                     Index, Cost: Node id and edge cost types
+ *                     const Index size() const:
+ *                       The number of nodes, ids range from 0 to size() - 1
+ *                     const Cost heuristic(Index id, Index goal) const:
+ *                       The estimated distance between @id and @goal, not greater than the actual path
+ *                     template <typename Visitor> void for_each_successor(Index id, Visitor &&visit) const:
+ *                       Calls visit(successor, cost) for every available successor of @id
+ *                   Graphs pruning their successors based on the search, such as jump point search,
+ *                   may instead provide the following member, which is preferred when present:
+ *                     template <typename Visitor> void for_each_successor(Index id, Index prev, Index goal, Visitor &&visit) const:
+ *                       Calls visit(successor, cost) for the successors of @id reached from @prev (none for the start)
+ *                   Graphs with at most eight successors per node may additionally provide the following member,
+ *                   which is preferred when present and lets the search relax all successors together:
+ *                     const unsigned int neighbourhood(Index id, Index goal, Index (&successors)[8], Cost (&costs)[8], Cost (&heuristics)[8]) const:
+ *                       Writes the successors of @id, their costs and their heuristic to @goal, returning their number
+ *   open_list_type: Open list implementation, BinaryHeapOpenList, MultisetOpenList or, for integral costs, BucketOpenList
+ *   statistics_type: Statistics policy, NoStatistics or SearchStatistics
+ */
+
+template <typename graph_type,
+          template <typename, typename> class open_list_type>
+class BidirectionalAStar;
+
+template <typename graph_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList,
+          typename statistics_type = NoStatistics>
+class AStarSearch {
+	template <typename, template <typename, typename> class>
+	friend class BidirectionalAStar;
+public:
+	typedef graph_type            Graph;
+	typedef typename Graph::Index Index;
+	typedef typename Graph::Cost  Cost;
+	typedef typename std::vector<Index>::const_iterator PathIterator;
+	
+	/**
+	 * Id denoting no node, the predecessor of the start and the successor of the last path node.
+	 */
+	static const Index none;
+	
+	/**
+	 * Progress of a query searched in slices through start and step.
+	 */
+	enum Status {
+		Running,
+		Found,
+		Failed
+	};
+	
+	/**
+	 * Search data of a single node: the cost from the start, the heuristic to the target, the predecessor,
+	 * the position in the open list and the stamp of the search that reached it along with its closed flag.
+	 * While pending, h is only a lower bound and the heuristic is computed when the node is taken, see defer.
+	 * With 32-bit costs and ids a State takes 20 bytes. The priority g + inflation * h is not stored,
+	 * see priority.
+	 */
+	struct State {
+		Cost  g {0};
+		Cost  h {0};
+		Index prev {none};
+		Index slot {0};
+		unsigned int generation : 30;
+		unsigned int pending : 1;
+		unsigned int closed : 1;
+		
+		State(): generation(0), pending(0), closed(0) {}
+	};
+	
+protected:
+	
+	struct StateAccess {
+		StateAccess(std::vector<State> *states = nullptr, const Cost *inflation = nullptr): states(states), inflation(inflation) {}
+		std::vector<State> *states;
+		const Cost *inflation;
+		const bool less(const Index lhs, const Index rhs) const {
+			return priority(lhs) < priority(rhs);
+		}
+		const Cost priority(const Index id) const {
+			const State &state = (*states)[id];
+			return state.g + *inflation * state.h;
+		}
+		Index &slot(const Index id) const {
+			return (*states)[id].slot;
+		}};
+	struct SuccessorVisitor {
+		SuccessorVisitor(AStarSearch *search, Index current): search(search), current(current) {}
+		AStarSearch *search;
+		Index current;
+		void operator()(const Index successor, const Cost cost) const {
+			search->expand(current, successor, cost);
+		}};
+	
+	/**
+	 * Detects if a graph type supplies the successor interface taking the predecessor and goal.
+	 */
+	template <typename type>
+	struct PrunesSuccessors {
+		template <typename graph>
+		static auto test(int) -> decltype(std::declval<const graph&>().for_each_successor(Index(), Index(), Index(), std::declval<SuccessorVisitor>()),
+										  std::true_type());
+		template <typename>
+		static std::false_type test(...);
+		static const bool value = decltype(test<type>(0))::value;
+	};
+	/**
+	 * Detects if a graph type supplies all successors of a node at once, see relax.
+	 */
+	template <typename type>
+	struct VisitsNeighbourhood {
+		template <typename graph>
+		static auto test(int) -> decltype(std::declval<const graph&>().neighbourhood(Index(), Index(), std::declval<Index(&)[8]>(),
+																					  std::declval<Cost(&)[8]>(), std::declval<Cost(&)[8]>()),
+										  std::true_type());
+		template <typename>
+		static std::false_type test(...);
+		static const bool value = decltype(test<type>(0))::value;
+	};
+	
+	typedef open_list_type<Index, StateAccess> OpenList;
+	
+	const Graph *graph;
+	
+	/**
+	 * Stamp of the current search. States carrying a different stamp belong to earlier searches
+	 * and are reset the first time their node is reached.
+	 */
+	unsigned int generation {0};
+	std::vector<State> states;
+	OpenList openList;
+	
+	Index path_begin {none};
+	Index path_end {none};
+	Index nearest {none};
+	bool found {false};
+	bool running {false};
+	
+	/**
+	 * Node ids of the resulting path, from the start to the last path node.
+	 */
+	std::vector<Index> result {};
+	
+	/**
+	 * The search running in the opposite direction of a bidirectional search, and the cheapest
+	 * node both searches reached so far together with the cost of the path through it.
+	 */
+	const AStarSearch *opposite {nullptr};
+	Index meeting {none};
+	Cost meeting_weight {0};
+	
+	/**
+	 * Factor of the heuristic in the priority f = g + inflation * h. Inflated searches do not reopen closed
+	 * nodes; an anytime search collects the closed nodes reached more cheaply in @inconsistent instead.
+	 */
+	Cost inflation {1};
+	std::vector<Index> *inconsistent {nullptr};
+	
+	/**
+	 * Heuristic cache and deferred heuristics, see cache and defer. The heuristics of the states stamped
+	 * @heuristics_from or later were computed towards @heuristic_goal.
+	 */
+	bool caching {false};
+	bool deferring {false};
+	Index heuristic_goal {none};
+	unsigned int heuristics_from {0};
+	
+	statistics_type searchStatistics {};
+	
+	void stamp    ();
+	State &visit  (Index id);
+	State &visit  (Index id, Cost h);
+	State &visit  (Index id, Index current, Cost cost);
+	State &initialise(State &state, Cost h);
+	State &refresh(State &state);
+	void prepare  ();
+	const bool advance();
+	void calculate();
+	void successors(Index current, std::true_type);
+	void successors(Index current, std::false_type);
+	void relax    (Index current, std::true_type);
+	void relax    (Index current, std::false_type);
+	void expand   (Index current, Index successor, Cost cost);
+	void expand   (Index current, Index successor, State &next, Cost cost);
+	void backlink (Index last);
+	
+	/**
+	 * Returns the mask of the @count lanes in which @g + @costs improves on @known, as improves does.
+	 */
+	static const unsigned int improvements(Cost g, const Cost (&costs)[8], const Cost (&known)[8], unsigned int count, std::false_type) {
+		unsigned int mask = 0;
+		for(unsigned int lane = 0; lane < count; ++lane) {
+			mask |= unsigned(improves(g + costs[lane], known[lane])) << lane;
+		}
+		return mask;
+	}
+	static const unsigned int improvements(Cost g, const Cost (&costs)[8], const Cost (&known)[8], unsigned int count, std::true_type) {
+		const typename Lanes::Vector base = Lanes::broadcast(g);
+		const typename Lanes::Vector epsilon = Lanes::broadcast(std::numeric_limits<Cost>::epsilon());
+		unsigned int mask = 0;
+		for(unsigned int lane = 0; lane < count; lane += Lanes::width) {
+			const typename Lanes::Vector candidate = Lanes::add(base, Lanes::load(costs + lane));
+			const typename Lanes::Vector previous = Lanes::load(known + lane);
+			mask |= (Lanes::less(candidate, previous) & Lanes::less_equal(epsilon, Lanes::sub(previous, candidate))) << lane;
+		}
+		return mask & ((1u << count) - 1);
+	}
+	
+	/**
+	 * Returns if the cost @g improves on @current. Floating point costs have to improve by more than
+	 * their rounding error, so that equal paths summed in a different order are not reopened.
+	 */
+	static const bool improves(Cost g, Cost current) {
+		return improves(g, current, std::integral_constant<bool, std::numeric_limits<Cost>::is_integer>());
+	}
+	static const bool improves(Cost g, Cost current, std::true_type) {
+		return g < current;
+	}
+	static const bool improves(Cost g, Cost current, std::false_type) {
+		return g < current && !(current - g < std::numeric_limits<Cost>::epsilon());
+	}
+	
+public:
+	explicit AStarSearch(const Graph &graph);
+	AStarSearch(const AStarSearch &) = delete;
+	AStarSearch &operator=(const AStarSearch &) = delete;
+	
+	/**
+	 * Searches the path from @path_begin to @path_end, replacing the result of the previous query.
+	 * Returns if the target was reached, see successful().
+	 */
+	const bool query(Index path_begin, Index path_end);
+	/**
+	 * Begins a query from @path_begin to @path_end without expanding any node. The search is then
+	 * carried out by calls to step, so a long query can be spread over several frames.
+	 */
+	void start(Index path_begin, Index path_end);
+	/**
+	 * Expands up to @max_expansions nodes of the query begun by start. The open list is kept between
+	 * calls, so the search continues where the last call stopped. Returns Running while the search
+	 * is not done; once it returns Found or Failed, the result is available as after query.
+	 */
+	const Status step(std::size_t max_expansions = std::numeric_limits<std::size_t>::max());
+	/**
+	 * Returns the progress of the current query, Failed if there is none.
+	 */
+	const Status status() const {
+		return running ? Running : found ? Found : Failed;
+	}
+	/**
+	 * Discards the result of the previous query. Called by query, the per-node data is reset lazily.
+	 */
+	void reset();
+	/**
+	 * Preallocates the open list for @count nodes, a hint for the largest frontier expected by the queries.
+	 */
+	void reserve(std::size_t count) {
+		openList.reserve(count);
+	}
+	/**
+	 * Weighted A*: expands by the priority g + @factor * h. With @factor > 1 the search expands fewer nodes,
+	 * and the path may be up to @factor times as long as the shortest path. The default factor is 1.
+	 */
+	void inflate(Cost factor) {
+		inflation = factor;
+	}
+	const Cost inflated() const {
+		return inflation;
+	}
+	/**
+	 * Keeps the heuristics computed by a query for the following queries to the same target, so an expensive
+	 * heuristic, such as that of Landmarks, is computed once per node and target. The heuristics are kept
+	 * until the target changes or forget is called, which is needed when the heuristic of the graph
+	 * changes for the same target. Off by default.
+	 */
+	void cache(bool enabled) {
+		caching = enabled;
+	}
+	void forget() {
+		heuristic_goal = none;
+	}
+	/**
+	 * Defers the heuristic of a newly reached node: it is queued with the heuristic of its predecessor
+	 * less the cost of the edge, a lower bound of its own, and its heuristic is computed when it is taken
+	 * from the open list. If that raises its priority it is queued again instead of expanded. Saves the
+	 * heuristics of the nodes left in the open list, at the cost of queueing some nodes twice. Graphs
+	 * supplying the heuristics with their neighbourhood are not deferred. Off by default.
+	 */
+	void defer(bool enabled) {
+		deferring = enabled;
+	}
+	/**
+	 * The statistics policy of the search, see SearchStatistics.
+	 */
+	statistics_type &statistics() {
+		return searchStatistics;
+	}
+	const statistics_type &statistics() const {
+		return searchStatistics;
+	}
+	
+	/**
+	 * Returns if the target was reached. Otherwise the result is the path to the node nearest to the target.
+	 */
+	const bool         successful() const;
+	const Cost         weight() const;
+	const unsigned int steps() const;
+	
+	/**
+	 * Returns the search data of @id, valid for nodes on the resulting path.
+	 */
+	const State &state(const Index id) const {
+		return states[id];
+	}
+	/**
+	 * Returns if @id was reached by the current query.
+	 */
+	const bool visited(const Index id) const {
+		return states[id].generation == generation;
+	}
+	/**
+	 * The priority of @id in the open list, g + inflation * h.
+	 */
+	const Cost priority(const Index id) const {
+		return states[id].g + inflation * states[id].h;
+	}
+	
+	/**
+	 * The node ids of the resulting path, from the start to the last path node, stored contiguously.
+	 * The path is owned by the search and replaced by the next query; copy it to keep it.
+	 */
+	const std::vector<Index> &path() const {
+		return result;
+	}
+	/**
+	 * Copies the resulting path to @out, reusing its storage.
+	 */
+	void path(std::vector<Index> &out) const {
+		out.assign(result.begin(), result.end());
+	}
+	
+	const PathIterator begin() const {
+		return result.begin();
+	}
+	const PathIterator end() const {
+		return result.end();
+	}
+};
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const typename AStarSearch<graph_type, open_list_type, statistics_type>::Index AStarSearch<graph_type, open_list_type, statistics_type>::none = std::numeric_limits<Index>::max();
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+AStarSearch<graph_type, open_list_type, statistics_type>::AStarSearch(const Graph &graph):
+graph(&graph), states(graph.size()), openList(StateAccess(&states, &inflation)) {
+	
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const bool AStarSearch<graph_type, open_list_type, statistics_type>::query(Index path_begin, Index path_end) {
+	reset();
+	this->path_begin = path_begin;
+	this->path_end = path_end;
+	calculate();
+	backlink(nearest);
+	return found;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::start(Index path_begin, Index path_end) {
+	reset();
+	this->path_begin = path_begin;
+	this->path_end = path_end;
+	prepare();
+	running = true;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const typename AStarSearch<graph_type, open_list_type, statistics_type>::Status AStarSearch<graph_type, open_list_type, statistics_type>::step(std::size_t max_expansions) {
+	if(!running) {
+		return status();
+	}
+	for(std::size_t expansion = 0; expansion < max_expansions; ++expansion) {
+		if(!advance()) {
+			running = false;
+			backlink(nearest);
+			break;
+		}
+	}
+	return status();
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::reset() {
+	openList.clear();
+	stamp();
+	path_begin = none;
+	path_end = none;
+	nearest = none;
+	found = false;
+	running = false;
+	meeting = none;
+	result.clear();
+	searchStatistics.query();
+}
+
+/**
+ * Draws a fresh search stamp. When the counter wraps around, the stamps of all states are cleared once.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::stamp() {
+	generation = (generation + 1) & 0x3fffffff;
+	if(generation == 0) {
+		for(auto state = states.begin(); state != states.end(); ++state) {
+			state->generation = 0;
+		}
+		++generation;
+		heuristic_goal = none;
+	}
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+typename AStarSearch<graph_type, open_list_type, statistics_type>::State &AStarSearch<graph_type, open_list_type, statistics_type>::visit(Index id) {
+	State &state = states[id];
+	if(state.generation == generation) {
+		return state;
+	}
+	if(caching && state.generation >= heuristics_from) {
+		return refresh(state);
+	}
+	return initialise(state, graph->heuristic(id, path_end));
+}
+
+/**
+ * Visits @id with its heuristic @h already computed, such as by the neighbourhood of a graph.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+typename AStarSearch<graph_type, open_list_type, statistics_type>::State &AStarSearch<graph_type, open_list_type, statistics_type>::visit(Index id, Cost h) {
+	State &state = states[id];
+	return state.generation == generation ? state : initialise(state, h);
+}
+
+/**
+ * Visits @id reached from @current over an edge of @cost. A deferring search queues it with a lower bound of its heuristic.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+typename AStarSearch<graph_type, open_list_type, statistics_type>::State &AStarSearch<graph_type, open_list_type, statistics_type>::visit(Index id, Index current, Cost cost) {
+	State &state = states[id];
+	if(!deferring || state.generation == generation || (caching && state.generation >= heuristics_from)) {
+		return visit(id);
+	}
+	// A heuristic h is admissible only if h(current) <= cost + h(id), so h(current) - cost bounds h(id)
+	const Cost h = states[current].h;
+	refresh(state);
+	state.h = h > cost ? h - cost : Cost(0);
+	state.pending = true;
+	return state;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+typename AStarSearch<graph_type, open_list_type, statistics_type>::State &AStarSearch<graph_type, open_list_type, statistics_type>::initialise(State &state, Cost h) {
+	refresh(state);
+	state.h = h;
+	state.pending = false;
+	searchStatistics.heuristic();
+	return state;
+}
+
+/**
+ * Stamps @state for the current search and resets all of its data but the heuristic.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+typename AStarSearch<graph_type, open_list_type, statistics_type>::State &AStarSearch<graph_type, open_list_type, statistics_type>::refresh(State &state) {
+	state.generation = generation;
+	state.g = 0;
+	state.closed = false;
+	state.slot = 0;
+	state.prev = none;
+	return state;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::prepare() {
+	if(!caching || path_end != heuristic_goal) {
+		heuristic_goal = path_end;
+		heuristics_from = generation;
+	}
+	visit(path_begin);
+	openList.push(path_begin);
+	searchStatistics.push(openList.size());
+}
+
+/**
+ * Expands the next node of the open list. Returns false once the target was reached or the open list is exhausted.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const bool AStarSearch<graph_type, open_list_type, statistics_type>::advance() {
+	if(openList.empty()) {
+		// NOT FOUND
+		return false;
+	}
+	Index current = openList.pop();
+	State &state = states[current];
+	if(state.pending) {
+		// A deferred heuristic is computed now, the node goes back if its priority rises
+		state.pending = false;
+		const Cost h = graph->heuristic(current, path_end);
+		searchStatistics.heuristic();
+		if(h > state.h) {
+			state.h = h;
+			openList.push(current);
+			searchStatistics.push(openList.size());
+			return true;
+		}
+	}
+	state.closed = true;
+	searchStatistics.expand(current, state.g, priority(current));
+	if(nearest == none || state.h < states[nearest].h) {
+		nearest = current;
+	}
+	
+	if(current == path_end) {
+		// FOUND
+		nearest = current;
+		found = true;
+		return false;
+	}
+	
+	successors(current, std::integral_constant<bool, PrunesSuccessors<Graph>::value>());
+	return true;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::calculate() {
+	prepare();
+	while(advance()) {}
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::successors(Index current, std::true_type) {
+	graph->for_each_successor(current, states[current].prev, path_end, SuccessorVisitor(this, current));
+}
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::successors(Index current, std::false_type) {
+	relax(current, std::integral_constant<bool, VisitsNeighbourhood<Graph>::value>());
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::relax(Index current, std::false_type) {
+	graph->for_each_successor(current, SuccessorVisitor(this, current));
+}
+
+/**
+ * Relaxes all successors of @current together: the graph supplies them with their costs and heuristics,
+ * the candidate costs are compared to the known costs in vector lanes, and only the successors whose
+ * cost improves are expanded further.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::relax(Index current, std::true_type) {
+	Index successors[8];
+	Cost costs[8] {};
+	Cost heuristics[8];
+	Cost known[8] {};
+	const unsigned int count = graph->neighbourhood(current, path_end, successors, costs, heuristics);
+	// Every node of the current search but the start is visited only together with its predecessor, the
+	// start has the cost 0 that no successor improves on.
+	for(unsigned int lane = 0; lane < count; ++lane) {
+		const State &next = states[successors[lane]];
+		known[lane] = next.generation == generation ? next.g : std::numeric_limits<Cost>::max();
+	}
+	const unsigned int mask = improvements(states[current].g, costs, known, count, std::is_same<Cost, double>());
+	for(unsigned int lane = 0; lane < count; ++lane) {
+		if(mask & (1u << lane)) {
+			expand(current, successors[lane], visit(successors[lane], heuristics[lane]), costs[lane]);
+		}
+		else {
+			searchStatistics.reject();
+		}
+	}
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::expand(Index current, Index successor, Cost cost) {
+	expand(current, successor, visit(successor, current, cost), cost);
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::expand(Index current, Index successor, State &next, Cost cost) {
+	const State &state = states[current];
+	Cost g = state.g + cost;
+	const bool open = openList.contains(successor);
+	// Nodes reached before keep their cost, also when an anytime search cleared their closed flags
+	if(open || next.closed || next.prev != none || successor == path_begin) {
+		if(!improves(g, next.g)) {
+			searchStatistics.reject();
+			return;
+		}
+	}
+	// A closed node is only reached more cheaply if the heuristic is inconsistent or inflated
+	if(next.closed && inflation > 1) {
+		if(inconsistent) {
+			next.prev = current;
+			next.g = g;
+			inconsistent->push_back(successor);
+			searchStatistics.reopen();
+		}
+		else {
+			searchStatistics.reject();
+		}
+		return;
+	}
+	if(next.closed) {
+		searchStatistics.reopen();
+	}
+	next.closed = false;
+	next.prev = current;
+	next.g = g;
+	
+	if(opposite && opposite->visited(successor)) {
+		const Cost weight = g + opposite->states[successor].g;
+		if(meeting == none || weight < meeting_weight) {
+			meeting = successor;
+			meeting_weight = weight;
+		}
+	}
+	
+	if(open) {
+		openList.update(successor);
+		searchStatistics.decrease();
+	}
+	else {
+		openList.push(successor);
+		searchStatistics.push(openList.size());
+	}
+}
+
+/**
+ * Collects the path ending in @last by following the predecessors back to the start, then flips it in place.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AStarSearch<graph_type, open_list_type, statistics_type>::backlink(Index last) {
+	result.clear();
+	for(; last != none; last = states[last].prev) {
+		result.push_back(last);
+	}
+	std::reverse(result.begin(), result.end());
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const bool AStarSearch<graph_type, open_list_type, statistics_type>::successful() const {
+	return found;
+}
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const typename AStarSearch<graph_type, open_list_type, statistics_type>::Cost AStarSearch<graph_type, open_list_type, statistics_type>::weight() const {
+	return nearest != none ? states[nearest].g : 0;
+}
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const unsigned int AStarSearch<graph_type, open_list_type, statistics_type>::steps() const {
+	return result.empty() ? 0 : static_cast<unsigned int>(result.size() - 1);
+}
+
+/**
+ * View of a graph in one search direction, the graph_type of the searches of BidirectionalAStar.
+ *
+ * The reverse direction follows the member
+ *   template <typename Visitor> void for_each_predecessor(Index id, Visitor &&visit) const
+ * calling visit(predecessor, cost) for every node with an edge to @id, when the graph provides it.
+ * Otherwise the graph is treated as undirected and the successors are followed in both directions.
+ */
+template <typename graph_type>
+class DirectedGraph {
+public:
+	typedef typename graph_type::Index Index;
+	typedef typename graph_type::Cost  Cost;
+	
+private:
+	const graph_type *graph;
+	bool reverse;
+	
+	template <typename type>
+	struct VisitsPredecessors {
+		struct ProbeVisitor {
+			void operator()(const Index predecessor, const Cost cost) const {}
+		};
+		template <typename graph>
+		static auto test(int) -> decltype(std::declval<const graph&>().for_each_predecessor(Index(), std::declval<ProbeVisitor&>()),
+										  std::true_type());
+		template <typename>
+		static std::false_type test(...);
+		static const bool value = decltype(test<type>(0))::value;
+	};
+	
+	template <typename visitor_type>
+	void predecessors(const Index id, visitor_type &visit, std::true_type) const {
+		graph->for_each_predecessor(id, visit);
+	}
+	template <typename visitor_type>
+	void predecessors(const Index id, visitor_type &visit, std::false_type) const {
+		graph->for_each_successor(id, visit);
+	}
+	
+public:
+	DirectedGraph(const graph_type &graph, bool reverse): graph(&graph), reverse(reverse) {}
+	
+	const Index size() const {
+		return graph->size();
+	}
+	/**
+	 * The version of the graph, present if the graph has one, see Grid::version.
+	 */
+	template <typename base_type = graph_type>
+	auto version() const -> decltype(std::declval<const base_type&>().version()) {
+		return graph->version();
+	}
+	const Cost heuristic(const Index id, const Index goal) const {
+		return graph->heuristic(id, goal);
+	}
+	template <typename visitor_type>
+	void for_each_successor(const Index id, visitor_type &&visit) const {
+		if(reverse) {
+			predecessors(id, visit, std::integral_constant<bool, VisitsPredecessors<graph_type>::value>());
+		}
+		else {
+			graph->for_each_successor(id, visit);
+		}
+	}
+};
 
 /**
- * A* (A-Star) graph search algorithm implementation.
+ * General graph in compressed sparse row form, for road networks, navigation meshes and other graphs
+ * with millions of edges. The edges of all nodes are stored in three contiguous arrays: the edges of
+ * node i are the entries offsets[i] to offsets[i + 1] - 1 of the target and cost arrays, so visiting
+ * the successors of a node is a plain loop over one slice of them.
+ *
+ * Edges are directed. The reversed edges are stored on request, for BidirectionalAStar and DStarLite
+ * on graphs with one-way edges; without them the graph is treated as undirected by both.
+ *
+ * The heuristic is the euclidean distance between the positions of the nodes times a scale, zero until
+ * positions are set. The scale has to keep it below the cost of every path, such as one over the highest
+ * speed of a road network weighted by travel time. Landmarks give a tighter bound on road networks.
+ *
+ * Searches touch the data of nodes close to each other in the graph. permute renumbers the nodes so they
+ * are also close to each other in memory, in breadth-first order or along a Hilbert curve through their
+ * positions, which reduces cache misses on graphs numbered arbitrarily.
+ *
+ * Models the graph_type of AStarSearch.
  *
  * Template parameters:
- *   node_type:       Type representing a node. Must implement AStar::NodeBase.
- *   collection_type: Any collection that provides at least std::forward_iterator_tag iteration
+ *   cost_type:  Type of the edge costs
+ *   index_type: Unsigned type of the node ids and edge offsets; the number of edges has to fit into it
+ */
+template <typename cost_type = double, typename index_type = std::uint32_t>
+class CSRGraph {
+public:
+	typedef index_type Index;
+	typedef cost_type  Cost;
+	
+	struct Edge {
+		Index from;
+		Index to;
+		Cost  cost;
+	};
+	struct Position {
+		double x;
+		double y;
+		double z;
+	};
+	
+private:
+	std::vector<Index> offsets {0};
+	std::vector<Index> targets {};
+	std::vector<Cost>  costs {};
+	std::vector<Index> reverseOffsets {};
+	std::vector<Index> reverseTargets {};
+	std::vector<Cost>  reverseCosts {};
+	std::vector<Position> positions {};
+	double factor {1};
+	std::uint64_t changes {0};
+	
+	void invert();
+	
+public:
+	CSRGraph() {}
+	/**
+	 * Creates a graph of @count nodes from a list of @edges in any order. The edges of a node keep their
+	 * order in the list. With @predecessors the reversed edges are stored as well.
+	 */
+	CSRGraph(Index count, const std::vector<Edge> &edges, bool predecessors = false);
+	/**
+	 * Creates a graph from arrays already in compressed sparse row form, @offsets holding one entry more than there are nodes.
+	 */
+	CSRGraph(std::vector<Index> offsets, std::vector<Index> targets, std::vector<Cost> costs, bool predecessors = false);
+	
+	const Index size() const {
+		return Index(offsets.size() - 1);
+	}
+	const Index edges() const {
+		return Index(targets.size());
+	}
+	const Index degree(Index id) const {
+		return offsets[id + 1] - offsets[id];
+	}
+	/**
+	 * Counts the changes of the graph, increased whenever permute renumbers the nodes, see Grid::version.
+	 */
+	const std::uint64_t version() const {
+		return changes;
+	}
+	/**
+	 * Sets the position of @id used by the heuristic. Positions are set for all nodes or for none.
+	 */
+	void place(Index id, double x, double y, double z = 0) {
+		if(positions.size() != size()) {
+			positions.assign(size(), Position {0, 0, 0});
+		}
+		positions[id] = Position {x, y, z};
+	}
+	const Position &position(Index id) const {
+		return positions[id];
+	}
+	/**
+	 * Sets the factor between the distance of two positions and the heuristic, 1 by default.
+	 */
+	void scale(double factor) {
+		this->factor = factor;
+	}
+	
+	const Cost heuristic(Index id, Index goal) const {
+		if(positions.empty()) {
+			return Cost(0);
+		}
+		const Position &from = positions[id];
+		const Position &to = positions[goal];
+		const double dx = from.x - to.x, dy = from.y - to.y, dz = from.z - to.z;
+		return Cost(factor * std::sqrt(dx * dx + dy * dy + dz * dz));
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		for(Index edge = offsets[id], last = offsets[id + 1]; edge < last; ++edge) {
+			visit(targets[edge], costs[edge]);
+		}
+	}
+	/**
+	 * Follows the reversed edges if they are stored, otherwise the successors.
+	 */
+	template <typename visitor_type>
+	void for_each_predecessor(Index id, visitor_type &&visit) const {
+		if(reverseOffsets.empty()) {
+			for_each_successor(id, visit);
+			return;
+		}
+		for(Index edge = reverseOffsets[id], last = reverseOffsets[id + 1]; edge < last; ++edge) {
+			visit(reverseTargets[edge], reverseCosts[edge]);
+		}
+	}
+	
+	/**
+	 * The node ids in breadth-first order, starting a new traversal at the lowest id not yet reached.
+	 */
+	std::vector<Index> breadth_first_order() const;
+	/**
+	 * The node ids in the order of a Hilbert curve through the x and y coordinates of their positions,
+	 * or in their current order if no positions are set.
+	 */
+	std::vector<Index> hilbert_order() const;
+	/**
+	 * Renumbers the nodes so that node @order[i] becomes node i, @order holding every id once. Returns the
+	 * new id of every former id, for translating queries and data indexed by node.
+	 */
+	std::vector<Index> permute(const std::vector<Index> &order);
+};
+
+template<typename cost_type, typename index_type>
+CSRGraph<cost_type, index_type>::CSRGraph(Index count, const std::vector<Edge> &edges, bool predecessors):
+offsets(count + std::size_t(1), 0), targets(edges.size()), costs(edges.size()) {
+	for(auto edge = edges.begin(); edge != edges.end(); ++edge) {
+		++offsets[edge->from + 1];
+	}
+	for(Index id = 0; id < count; ++id) {
+		offsets[id + 1] += offsets[id];
+	}
+	std::vector<Index> cursor(offsets.begin(), offsets.end() - 1);
+	for(auto edge = edges.begin(); edge != edges.end(); ++edge) {
+		const Index slot = cursor[edge->from]++;
+		targets[slot] = edge->to;
+		costs[slot] = edge->cost;
+	}
+	if(predecessors) {
+		invert();
+	}
+}
+
+template<typename cost_type, typename index_type>
+CSRGraph<cost_type, index_type>::CSRGraph(std::vector<Index> offsets, std::vector<Index> targets, std::vector<Cost> costs, bool predecessors):
+offsets(std::move(offsets)), targets(std::move(targets)), costs(std::move(costs)) {
+	if(this->offsets.empty()) {
+		this->offsets.push_back(0);
+	}
+	if(predecessors) {
+		invert();
+	}
+}
+
+/**
+ * Stores the reversed edges, sorted by their target like the edges by their source.
+ */
+template<typename cost_type, typename index_type>
+void CSRGraph<cost_type, index_type>::invert() {
+	reverseOffsets.assign(offsets.size(), 0);
+	reverseTargets.resize(targets.size());
+	reverseCosts.resize(costs.size());
+	for(auto target = targets.begin(); target != targets.end(); ++target) {
+		++reverseOffsets[*target + 1];
+	}
+	for(Index id = 0; id < size(); ++id) {
+		reverseOffsets[id + 1] += reverseOffsets[id];
+	}
+	std::vector<Index> cursor(reverseOffsets.begin(), reverseOffsets.end() - 1);
+	for(Index id = 0; id < size(); ++id) {
+		for(Index edge = offsets[id]; edge < offsets[id + 1]; ++edge) {
+			const Index slot = cursor[targets[edge]]++;
+			reverseTargets[slot] = id;
+			reverseCosts[slot] = costs[edge];
+		}
+	}
+}
+
+template<typename cost_type, typename index_type>
+std::vector<index_type> CSRGraph<cost_type, index_type>::breadth_first_order() const {
+	std::vector<Index> order;
+	order.reserve(size());
+	std::vector<bool> reached(size(), false);
+	for(Index root = 0; root < size(); ++root) {
+		if(reached[root]) {
+			continue;
+		}
+		reached[root] = true;
+		order.push_back(root);
+		for(std::size_t next = order.size() - 1; next < order.size(); ++next) {
+			const Index id = order[next];
+			for(Index edge = offsets[id]; edge < offsets[id + 1]; ++edge) {
+				if(!reached[targets[edge]]) {
+					reached[targets[edge]] = true;
+					order.push_back(targets[edge]);
+				}
+			}
+		}
+	}
+	return order;
+}
+
+template<typename cost_type, typename index_type>
+std::vector<index_type> CSRGraph<cost_type, index_type>::hilbert_order() const {
+	std::vector<Index> order(size());
+	for(Index id = 0; id < size(); ++id) {
+		order[id] = id;
+	}
+	if(positions.empty()) {
+		return order;
+	}
+	double left = std::numeric_limits<double>::max(), right = std::numeric_limits<double>::lowest();
+	double bottom = left, top = right;
+	for(auto position = positions.begin(); position != positions.end(); ++position) {
+		left = std::min(left, position->x);
+		right = std::max(right, position->x);
+		bottom = std::min(bottom, position->y);
+		top = std::max(top, position->y);
+	}
+	// Distance along the curve through a grid of 2^16 x 2^16 cells covering all positions
+	const std::uint32_t cells = 1 << 16;
+	const double extent = std::max(std::max(right - left, top - bottom), std::numeric_limits<double>::min());
+	std::vector<std::uint64_t> keys(size());
+	for(Index id = 0; id < size(); ++id) {
+		std::uint32_t x = std::min(std::uint32_t((positions[id].x - left) / extent * (cells - 1)), cells - 1);
+		std::uint32_t y = std::min(std::uint32_t((positions[id].y - bottom) / extent * (cells - 1)), cells - 1);
+		std::uint64_t key = 0;
+		for(std::uint32_t half = cells / 2; half > 0; half /= 2) {
+			const std::uint32_t rx = (x & half) ? 1 : 0;
+			const std::uint32_t ry = (y & half) ? 1 : 0;
+			key += std::uint64_t(half) * half * ((3 * rx) ^ ry);
+			if(ry == 0) {
+				if(rx == 1) {
+					x = cells - 1 - x;
+					y = cells - 1 - y;
+				}
+				std::swap(x, y);
+			}
+		}
+		keys[id] = key;
+	}
+	std::stable_sort(order.begin(), order.end(), [&keys](const Index lhs, const Index rhs) {
+		return keys[lhs] < keys[rhs];
+	});
+	return order;
+}
+
+template<typename cost_type, typename index_type>
+std::vector<index_type> CSRGraph<cost_type, index_type>::permute(const std::vector<Index> &order) {
+	std::vector<Index> ids(size());
+	for(Index id = 0; id < size(); ++id) {
+		ids[order[id]] = id;
+	}
+	std::vector<Index> permutedOffsets(offsets.size(), 0);
+	std::vector<Index> permutedTargets(targets.size());
+	std::vector<Cost>  permutedCosts(costs.size());
+	for(Index id = 0; id < size(); ++id) {
+		const Index from = order[id];
+		Index slot = permutedOffsets[id];
+		for(Index edge = offsets[from]; edge < offsets[from + 1]; ++edge, ++slot) {
+			permutedTargets[slot] = ids[targets[edge]];
+			permutedCosts[slot] = costs[edge];
+		}
+		permutedOffsets[id + 1] = slot;
+	}
+	offsets.swap(permutedOffsets);
+	targets.swap(permutedTargets);
+	costs.swap(permutedCosts);
+	if(!positions.empty()) {
+		std::vector<Position> permutedPositions(positions.size());
+		for(Index id = 0; id < size(); ++id) {
+			permutedPositions[id] = positions[order[id]];
+		}
+		positions.swap(permutedPositions);
+	}
+	if(!reverseOffsets.empty()) {
+		invert();
+	}
+	++changes;
+	return ids;
+}
+
+/**
+ * Bidirectional A* search. A forward search from the start and a backward search from the target
+ * expand alternately, always advancing the smaller frontier, and meet in the middle.
+ *
+ * Every node reached by both searches closes a path; the cheapest of them is kept. The search stops
+ * as soon as the smallest f value of either open list is not below the cost of that path (the
+ * symmetric approach of Goldberg and Harrelson), which is exact for consistent heuristics.
+ * The backward search estimates the distance to the start through heuristic(id, start), so the
+ * heuristic has to be admissible in both directions, as geometric distances are.
+ *
+ * If the target is unreachable, the result is the path of the forward search to the node nearest to the target.
+ *
+ * Template parameters:
+ *   graph_type:     See AStarSearch. Directed graphs provide for_each_predecessor, see DirectedGraph.
+ *   open_list_type: Open list implementation, BinaryHeapOpenList or MultisetOpenList
+ */
+template <typename graph_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList>
+class BidirectionalAStar {
+public:
+	typedef graph_type                             Graph;
+	typedef DirectedGraph<Graph>                   View;
+	typedef AStarSearch<View, open_list_type>      Search;
+	typedef typename Search::Index                 Index;
+	typedef typename Search::Cost                  Cost;
+	typedef typename Search::PathIterator          PathIterator;
+	
+private:
+	View forwardView;
+	View backwardView;
+	Search forward;
+	Search backward;
+	
+	Index meeting {Search::none};
+	Cost meeting_weight {0};
+	std::vector<Index> result {};
+	
+	void meet();
+	
+public:
+	explicit BidirectionalAStar(const Graph &graph);
+	BidirectionalAStar(const BidirectionalAStar &) = delete;
+	BidirectionalAStar &operator=(const BidirectionalAStar &) = delete;
+	
+	/**
+	 * Searches the path from @path_begin to @path_end, replacing the result of the previous query.
+	 * Returns if the target was reached, see successful().
+	 */
+	const bool query(Index path_begin, Index path_end);
+	void reset();
+	void reserve(std::size_t count) {
+		forward.reserve(count);
+		backward.reserve(count);
+	}
+	
+	const bool         successful() const;
+	const Cost         weight() const;
+	const unsigned int steps() const;
+	
+	/**
+	 * The searches of both directions, holding the search data of their half of the path.
+	 */
+	const Search &forward_search() const {
+		return forward;
+	}
+	const Search &backward_search() const {
+		return backward;
+	}
+	
+	/**
+	 * The node ids of the stitched path: the path of the forward search up to the meeting node,
+	 * followed by the predecessors of the backward search from there on. See AStarSearch::path.
+	 */
+	const std::vector<Index> &path() const {
+		return result;
+	}
+	void path(std::vector<Index> &out) const {
+		out.assign(result.begin(), result.end());
+	}
+	
+	const PathIterator begin() const {
+		return result.begin();
+	}
+	const PathIterator end() const {
+		return result.end();
+	}
+};
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+BidirectionalAStar<graph_type, open_list_type>::BidirectionalAStar(const Graph &graph):
+forwardView(graph, false), backwardView(graph, true), forward(forwardView), backward(backwardView) {
+	forward.opposite = &backward;
+	backward.opposite = &forward;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+void BidirectionalAStar<graph_type, open_list_type>::reset() {
+	forward.reset();
+	backward.reset();
+	meeting = Search::none;
+	meeting_weight = 0;
+	result.clear();
+}
+
+/**
+ * Takes over the cheapest meeting node found by either search.
  */
+template<typename graph_type, template <typename, typename> class open_list_type>
+void BidirectionalAStar<graph_type, open_list_type>::meet() {
+	for(const Search *side: {&forward, &backward}) {
+		if(side->meeting != Search::none && (meeting == Search::none || side->meeting_weight < meeting_weight)) {
+			meeting = side->meeting;
+			meeting_weight = side->meeting_weight;
+		}
+	}
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+const bool BidirectionalAStar<graph_type, open_list_type>::query(Index path_begin, Index path_end) {
+	reset();
+	forward.path_begin = backward.path_end = path_begin;
+	forward.path_end = backward.path_begin = path_end;
+	forward.prepare();
+	backward.prepare();
+	if(path_begin == path_end) {
+		meeting = path_begin;
+	}
+	while(!forward.openList.empty() && !backward.openList.empty()) {
+		meet();
+		if(meeting != Search::none &&
+		   (forward.priority(forward.openList.top()) >= meeting_weight ||
+		    backward.priority(backward.openList.top()) >= meeting_weight)) {
+			break;
+		}
+		Search &side = forward.openList.size() <= backward.openList.size() ? forward : backward;
+		if(!side.advance()) {
+			break;
+		}
+	}
+	meet();
+	if(meeting != Search::none) {
+		forward.backlink(meeting);
+		result = forward.result;
+		for(Index next = backward.state(meeting).prev; next != Search::none; next = backward.state(next).prev) {
+			result.push_back(next);
+		}
+	}
+	else {
+		forward.backlink(forward.nearest);
+		result = forward.result;
+	}
+	return successful();
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+const bool BidirectionalAStar<graph_type, open_list_type>::successful() const {
+	return meeting != Search::none;
+}
+template<typename graph_type, template <typename, typename> class open_list_type>
+const typename BidirectionalAStar<graph_type, open_list_type>::Cost BidirectionalAStar<graph_type, open_list_type>::weight() const {
+	return meeting != Search::none ? meeting_weight : forward.weight();
+}
+template<typename graph_type, template <typename, typename> class open_list_type>
+const unsigned int BidirectionalAStar<graph_type, open_list_type>::steps() const {
+	return result.empty() ? 0 : static_cast<unsigned int>(result.size() - 1);
+}
+
+
 
+template <typename node_type,
+          template <typename...> class collection_type,
+          template <typename, typename> class open_list_type,
+          typename cost_type,
+          typename index_type>
+class AStar;
+
+/**
+ * Base of all node types, available as AStar::NodeBase.
+ *
+ * Node types derive from this template with themselves as @node_type. The functions below are
+ * resolved statically on @node_type instead of through virtual dispatch, so they can be inlined
+ * into the search loop and nodes carry no vtable pointer. A node type must provide:
+ *
+ *   Cost distance(const Node *rhs) const
+ *     The real distance between this node and its successor @rhs.
+ *   Cost heuristic(const Node *rhs) const
+ *     The estimated distance between this node and @rhs, not greater than the actual path.
+ *   Collection successors(const Iterator &collection_begin, const Iterator &collection_end) const
+ *     The nodes this node has active edges to.
+ *
+ * Instead of successors, node types may supply an allocation-free template member, which is preferred when present:
+ *   template <typename Visitor>
+ *   void for_each_successor(const Iterator &collection_begin, const Iterator &collection_end, Visitor &&visit) const;
+ * calling visit(successor) once for every successor.
+ *
+ * Cost is the cost_type of the AStar, double by default. Integral cost types allow the BucketOpenList.
+ *
+ * The node type does not depend on the open list, the same nodes can be searched with every AStar policy.
+ */
 template <typename node_type,
           template <typename...> class collection_type>
-class AStar {
-public:
-	class NodeBase;
-	class ResultIterator;
+class AStarNodeBase {
+	template <typename, template <typename...> class, template <typename, typename> class, typename, typename>
+	friend class AStar;
+protected:
+	/**
+	 * Dense id of this node, unique within its collection and smaller than the collections size.
+	 * Either assigned by the node implementation or through AStar::enumerate.
+	 */
+	std::size_t id {0};
+	bool        available {1};
 	
 	typedef node_type                     Node;
 	typedef collection_type<Node*>        Collection;
 	typedef typename Collection::iterator Iterator;
 	
-private:
+	~AStarNodeBase() {}
+};
+
+/**
+ * A* (A-Star) graph search algorithm implementation for nodes stored in a collection.
+ *
+ * Presents the collection to AStarSearch through a NodeGraph and maps the resulting path back to nodes.
+ * The nodes are only read during a search, so any number of AStar instances may search the same
+ * collection concurrently. An AStar instance is a reusable solver, see AStarSearch.
+ *
+ * Template parameters:
+ *   node_type:       Type representing a node. Must derive from AStar::NodeBase.
+ *   collection_type: Any collection that provides at least std::forward_iterator_tag iteration
+ *   open_list_type:  Open list implementation, BinaryHeapOpenList, MultisetOpenList or, for integral
+ *                    cost types, BucketOpenList
+ *   cost_type:       Type of the distances and heuristics of the nodes and of the search data
+ *   index_type:      Unsigned type of the node ids in the search data, std::uint32_t halves the
+ *                    search data of collections with fewer than 2^32 nodes
+ */
+
+template <typename node_type,
+          template <typename...> class collection_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList,
+          typename cost_type = double,
+          typename index_type = std::size_t>
+class AStar {
+public:
+	class NodeGraph;
+	class ResultIterator;
 	
-	struct NodePointerEqual {
-		NodePointerEqual(Node *lhs): lhs(lhs) {}
-		const Node *lhs;
-		const bool operator()(const Node *rhs) const {
-			return lhs->operator==(rhs);
-		}};
-	struct NodePointerLess {
-		const bool operator()(const Node *lhs, const Node *rhs) const {
-			return lhs->operator< (rhs);
-		}};
-	struct NodePointerLessHeuristicDistance {
-		const bool operator()(const Node *lhs, const Node *rhs) const {
-			return lhs->h < rhs->h;
-		}};
+	typedef AStarNodeBase<node_type, collection_type> NodeBase;
 	
-	typedef std::multiset<Node*, NodePointerLess> OpenList;
-	typedef std::multiset<Node*, NodePointerLessHeuristicDistance> ClosedList;
-	typedef typename OpenList::iterator ListIterator;
+	typedef node_type                     Node;
+	typedef collection_type<Node*>        Collection;
+	typedef typename Collection::iterator Iterator;
 	
-	OpenList openList {};
-	ClosedList closedList {};
+	typedef AStarSearch<NodeGraph, open_list_type> SearchContext;
+	typedef typename SearchContext::State          State;
+	typedef typename SearchContext::Status         Status;
 	
-	Iterator collection_begin;
-	Iterator collection_end;
-	Iterator path_begin;
-	Iterator path_end;
+	/**
+	 * Assigns the ids 0 to n-1 to the nodes of a collection in iteration order.
+	 * Intended for graphs whose nodes have no natural dense numbering of their own.
+	 */
+	static void enumerate(Iterator collection_begin, Iterator collection_end);
 	
-	void calculate();
-	void expand   (Node *current, Node* successor);
-	void backlink (Node *first, Node *last);
+private:
+	NodeGraph graph;
+	SearchContext context;
 	
 public:
+	/**
+	 * Creates a solver for the graph in [@collection_begin, @collection_end) without searching.
+	 */
+	AStar(Iterator collection_begin,
+		  Iterator collection_end);
+	/**
+	 * Creates a solver and immediately queries the path from @path_begin to @path_end.
+	 */
 	AStar(Iterator collection_begin,
 		  Iterator collection_end,
 		  Iterator path_begin,
 		  Iterator path_end);
 	virtual ~AStar();
 	
+	/**
+	 * Searches the path from @path_begin to @path_end, replacing the result of the previous query.
+	 * Returns if the target was reached, see successful().
+	 */
+	const bool query(Node *path_begin, Node *path_end);
+	const bool query(Iterator path_begin, Iterator path_end);
+	/**
+	 * Begins a query searched in slices by step, see AStarSearch::start.
+	 */
+	void start(Node *path_begin, Node *path_end) {
+		context.start(path_begin->id, path_end->id);
+	}
+	/**
+	 * Expands up to @max_expansions nodes of the query begun by start, see AStarSearch::step.
+	 */
+	const Status step(std::size_t max_expansions = std::numeric_limits<std::size_t>::max()) {
+		return context.step(max_expansions);
+	}
+	/**
+	 * Discards the result of the previous query. Called by query, the per-node data is reset lazily.
+	 */
+	void reset();
+	/**
+	 * Preallocates the open list for @count nodes, see AStarSearch::reserve.
+	 */
+	void reserve(std::size_t count) {
+		context.reserve(count);
+	}
+	
 	const bool         successful() const;
-	const double       weight() const;
+	const cost_type    weight() const;
 	const unsigned int steps() const;
 	
+	/**
+	 * Returns the search data of @node, valid for nodes on the resulting path.
+	 */
+	const State &state(const Node &node) const;
+	/**
+	 * Returns the underlying search, holding the search data of the last query by node id.
+	 */
+	const SearchContext &search() const {
+		return context;
+	}
+	/**
+	 * Writes the nodes of the resulting path to @out, reusing its storage. The node ids of the path
+	 * are available contiguously through search().path().
+	 */
+	void path(std::vector<Node*> &out) const {
+		out.clear();
+		for(auto id = context.begin(); id != context.end(); ++id) {
+			out.push_back(graph.node(*id));
+		}
+	}
+	
 	const ResultIterator begin() const;
 	const ResultIterator end() const;
 };
 
-template<typename node_type, template <typename...> class collection_type>
-class AStar<node_type, collection_type>::NodeBase {
+/**
+ * Presents the nodes of a collection as a graph over their ids, see AStarSearch.
+ * Unavailable successors are skipped, the edge costs are the nodes distances.
+ */
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+class AStar<node_type, collection_type, open_list_type, cost_type, index_type>::NodeGraph {
 	friend AStar;
-	friend NodePointerLessHeuristicDistance;
-protected:
-	double       g {0};
-	double       f {0};
-	double       h {-1};
-	bool         available {1};
-	unsigned int step {0};
+private:
+	Iterator collection_begin;
+	Iterator collection_end;
+	std::vector<Node*> nodes {};
+	std::uint64_t changes {0};
 	
-	Node *prev {nullptr};
-	Node *next {nullptr};
+	template <typename visitor_type>
+	struct NodeVisitor {
+		NodeVisitor(const Node *current, visitor_type &visit): current(current), visit(visit) {}
+		const Node *current;
+		visitor_type &visit;
+		void operator()(Node *successor) const {
+			if(successor->available) {
+				visit(successor->id, current->distance(successor));
+			}
+		}};
+	struct ProbeVisitor {
+		void operator()(Node *successor) const {}
+	};
+	/**
+	 * Detects if a node type supplies the allocation-free for_each_successor interface.
+	 */
+	template <typename type>
+	struct VisitsSuccessors {
+		template <typename node>
+		static auto test(int) -> decltype(std::declval<const node&>().for_each_successor(std::declval<const Iterator&>(),
+																						  std::declval<const Iterator&>(),
+																						  std::declval<ProbeVisitor&>()),
+										  std::true_type());
+		template <typename>
+		static std::false_type test(...);
+		static const bool value = decltype(test<type>(0))::value;
+	};
+	/**
+	 * Detects if a node type supplies the successors interface.
+	 */
+	template <typename type>
+	struct ListsSuccessors {
+		template <typename node>
+		static auto test(int) -> decltype(std::declval<const node&>().successors(std::declval<const Iterator&>(),
+																				  std::declval<const Iterator&>()),
+										  std::true_type());
+		template <typename>
+		static std::false_type test(...);
+		static const bool value = decltype(test<type>(0))::value;
+	};
 	
-	typedef Collection Collection;
-	typedef Iterator Iterator;
+	template <typename visitor_type>
+	void successors(const Node *current, visitor_type &visit, std::true_type) const {
+		current->for_each_successor(collection_begin, collection_end, visit);
+	}
+	template <typename visitor_type>
+	void successors(const Node *current, visitor_type &visit, std::false_type) const {
+		Collection successors = current->successors(collection_begin, collection_end);
+		if(!successors.empty()) for(auto successor = successors.begin(); successor != successors.end(); ++successor) {
+			visit(*successor);
+		}
+	}
 	
 public:
-	virtual ~NodeBase() {};
+	typedef index_type  Index;
+	typedef cost_type   Cost;
 	
-	virtual const double     distance(const Node *rhs) const = 0;
-	virtual const double     heuristic(const Node *rhs) const = 0;
-	virtual const Collection successors(const Iterator &collection_begin, const Iterator &collection_end) const = 0;
+	NodeGraph(Iterator collection_begin, Iterator collection_end);
 	
-	virtual const bool operator< (const Node *rhs) const final {
-		return f < rhs->f;
-	};
-	virtual const bool operator==(const Node *rhs) const = 0;
+	const Index size() const {
+		return nodes.size();
+	}
+	Node *node(const Index id) const {
+		return nodes[id];
+	}
+	/**
+	 * Counts the changes of the nodes reported by changed, see Grid::version.
+	 */
+	const std::uint64_t version() const {
+		return changes;
+	}
+	/**
+	 * Reports a change of the nodes, such as of their available flags, distances or successors. Nodes are
+	 * changed by their owner, so the graph cannot notice it on its own.
+	 */
+	void changed() {
+		++changes;
+	}
+	const Cost heuristic(const Index id, const Index goal) const {
+		return nodes[id]->heuristic(nodes[goal]);
+	}
+	template <typename visitor_type>
+	void for_each_successor(const Index id, visitor_type &&visit) const {
+		static_assert(std::is_base_of<NodeBase, Node>::value, "node_type must derive from AStar::NodeBase");
+		static_assert(VisitsSuccessors<Node>::value || ListsSuccessors<Node>::value,
+		              "node_type must supply successors or for_each_successor, see AStar::NodeBase");
+		
+		typedef typename std::remove_reference<visitor_type>::type Visitor;
+		NodeVisitor<Visitor> adapter(nodes[id], visit);
+		successors(nodes[id], adapter, std::integral_constant<bool, VisitsSuccessors<Node>::value>());
+	}
 };
 
-template<typename node_type, template <typename...> class collection_type>
-class AStar<node_type, collection_type>::ResultIterator: public std::iterator<std::forward_iterator_tag, Node> {
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+class AStar<node_type, collection_type, open_list_type, cost_type, index_type>::ResultIterator: public std::iterator<std::forward_iterator_tag, Node> {
 	friend AStar;
 private:
-	Node *next {nullptr};
-	ResultIterator(Node* next):next(next) {}
+	const NodeGraph *graph {nullptr};
+	typename SearchContext::PathIterator next {};
+	ResultIterator(const NodeGraph *graph, typename SearchContext::PathIterator next): graph(graph), next(next) {}
 public:
 	ResultIterator() {}
-	ResultIterator(const ResultIterator &rhs): next(rhs.next) {}
+	ResultIterator(const ResultIterator &rhs): graph(rhs.graph), next(rhs.next) {}
 	ResultIterator &operator=(const ResultIterator &rhs) {
+		graph = rhs.graph;
 		next = rhs.next;
+		return *this;
 	}
 	const bool operator==(const ResultIterator &rhs) const {
-		return (!next && !rhs.next) || (next && rhs.next && next->operator==(rhs.next));
+		return next == rhs.next;
 	}
 	const bool operator!=(const ResultIterator &rhs) const {
 		return !operator==(rhs);
 	}
 	Node &operator*() {
-		return *next;
+		return *graph->node(*next);
 	}
 	Node *operator->() {
-		return next;
+		return graph->node(*next);
 	}
 	ResultIterator &operator++() {
-		next = next->next;
+		++next;
 		return *this;
 	}
 };
 
-template<typename node_type, template <typename...> class collection_type>
-AStar<node_type, collection_type>::AStar(Iterator collection_begin,
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+AStar<node_type, collection_type, open_list_type, cost_type, index_type>::NodeGraph::NodeGraph(Iterator collection_begin, Iterator collection_end):
+collection_begin(collection_begin), collection_end(collection_end) {
+	for(auto node = collection_begin; node != collection_end; ++node) {
+		if((*node)->id >= nodes.size()) {
+			nodes.resize((*node)->id + 1, nullptr);
+		}
+		nodes[(*node)->id] = *node;
+	}
+}
+
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+void AStar<node_type, collection_type, open_list_type, cost_type, index_type>::enumerate(Iterator collection_begin, Iterator collection_end) {
+	std::size_t id {0};
+	for(auto node = collection_begin; node != collection_end; ++node) {
+		(*node)->id = id++;
+	}
+}
+
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+AStar<node_type, collection_type, open_list_type, cost_type, index_type>::AStar(Iterator collection_begin,
+										 Iterator collection_end):
+graph(collection_begin, collection_end), context(graph) {
+	
+}
+
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+AStar<node_type, collection_type, open_list_type, cost_type, index_type>::AStar(Iterator collection_begin,
 										 Iterator collection_end,
 										 Iterator path_begin,
 										 Iterator path_end):
-collection_begin(collection_begin), collection_end(collection_end),
-path_begin(path_begin), path_end(path_end) {
-	calculate();
-	backlink(*++closedList.begin(), *path_begin);
+AStar(collection_begin, collection_end) {
+	query(path_begin, path_end);
 }
 
-template<typename node_type, template <typename...> class collection_type>
-AStar<node_type, collection_type>::~AStar() {
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+AStar<node_type, collection_type, open_list_type, cost_type, index_type>::~AStar() {
 	
 }
 
-template<typename node_type, template <typename...> class collection_type>
-void AStar<node_type, collection_type>::calculate() {
-	openList.insert(*path_begin);
-	while(!openList.empty()) {
-		auto currentIterator = openList.begin();
-		Node *current = *currentIterator;
-		
-		openList.erase(currentIterator);
-		closedList.insert(current);
-		
-		if(current == *path_end) {
-			// FOUND
-			break;
-		}
-		
-		Collection successors = current->successors(collection_begin, collection_end);
-		if(!successors.empty()) for(auto successor = successors.begin(); successor != successors.end(); ++successor) {
-			expand(current, *successor);
-		}
-	}
-	// NOT FOUND
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+const bool AStar<node_type, collection_type, open_list_type, cost_type, index_type>::query(Node *path_begin, Node *path_end) {
+	return context.query(path_begin->id, path_end->id);
 }
-
-template<typename node_type, template <typename...> class collection_type>
-void AStar<node_type, collection_type>::expand(Node *current, Node *successor) {
-	if(std::find_if(closedList.begin(), closedList.end(), NodePointerEqual(successor)) != closedList.end()) {
-		return;
-	}
-	if(!successor->available) {
-		return;
-	}
-	double g = current->g + current->distance(successor);
-	ListIterator position = std::find_if(openList.begin(), openList.end(), NodePointerEqual(successor));
-	if(position != openList.end()) {
-		if(g > successor->g || (-std::numeric_limits<double>::epsilon() < (g - successor->g) &&
-								(g - successor->g) < std::numeric_limits<double>::epsilon())) {
-			return;
-		}
-		position = openList.erase(position);
-	}
-	else {
-		successor->h = successor->heuristic(*path_end);
-	}
-	successor->prev = current;
-	successor->g = g;
-	successor->f = successor->h + g;
-	successor->step = current->step + 1;
-	
-	openList.insert(position, successor);
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+const bool AStar<node_type, collection_type, open_list_type, cost_type, index_type>::query(Iterator path_begin, Iterator path_end) {
+	return query(*path_begin, *path_end);
 }
 
-template<typename node_type, template <typename...> class collection_type>
-void AStar<node_type, collection_type>::backlink(Node *first, Node *last) {
-	for (;first->prev; first = first->prev) {
-		first->prev->next = first;
-	}
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+void AStar<node_type, collection_type, open_list_type, cost_type, index_type>::reset() {
+	context.reset();
 }
 
-template<typename node_type, template <typename...> class collection_type>
-const bool AStar<node_type, collection_type>::successful() const {
-	return *++closedList.begin() == *path_end;
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+const bool AStar<node_type, collection_type, open_list_type, cost_type, index_type>::successful() const {
+	return context.successful();
 }
-template<typename node_type, template <typename...> class collection_type>
-const double AStar<node_type, collection_type>::weight() const {
-	return (*++closedList.begin())->g;
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+const cost_type AStar<node_type, collection_type, open_list_type, cost_type, index_type>::weight() const {
+	return context.weight();
 }
-template<typename node_type, template <typename...> class collection_type>
-const unsigned int AStar<node_type, collection_type>::steps() const {
-	return (*++closedList.begin())->step;
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+const unsigned int AStar<node_type, collection_type, open_list_type, cost_type, index_type>::steps() const {
+	return context.steps();
+}
+
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+const typename AStar<node_type, collection_type, open_list_type, cost_type, index_type>::State &AStar<node_type, collection_type, open_list_type, cost_type, index_type>::state(const Node &node) const {
+	return context.state(node.id);
 }
 
-template<typename node_type, template <typename...> class collection_type>
-const typename AStar<node_type, collection_type>::ResultIterator AStar<node_type, collection_type>::begin() const {
-	return ResultIterator(*path_begin);
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+const typename AStar<node_type, collection_type, open_list_type, cost_type, index_type>::ResultIterator AStar<node_type, collection_type, open_list_type, cost_type, index_type>::begin() const {
+	return ResultIterator(&graph, context.begin());
 }
-template<typename node_type, template <typename...> class collection_type>
-const typename AStar<node_type, collection_type>::ResultIterator AStar<node_type, collection_type>::end() const {
-	return ResultIterator();
+template<typename node_type, template <typename...> class collection_type, template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+const typename AStar<node_type, collection_type, open_list_type, cost_type, index_type>::ResultIterator AStar<node_type, collection_type, open_list_type, cost_type, index_type>::end() const {
+	return ResultIterator(&graph, context.end());
 }
 
 
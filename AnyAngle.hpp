@@ -0,0 +1,212 @@
+//
+// Path smoothing by line of sight and any-angle search on grids
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_ANYANGLE_001_HPP
+#define SCU_ANYANGLE_001_HPP
+
+#include "AStar.hpp"
+#include "GridAStar.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+/**
+ * String pulling of the path in [@path_begin, @path_end): writes the waypoints of a path that goes straight
+ * between them to @out, the first and last node included. @visible(from, to) returns if the straight
+ * line between two nodes is free, and has to hold for consecutive nodes of the path.
+ *
+ * From every waypoint the next one is found by doubling the distance along the path while the line of
+ * sight holds, then bisecting between the last visible and the first hidden node. That takes a logarithmic
+ * number of checks per waypoint instead of one per node, but may stop short of the farthest visible node
+ * where an obstacle hides only part of the path. Returns the iterator past the last written waypoint.
+ */
+template <typename iterator_type, typename visible_type, typename output_iterator>
+output_iterator smooth(iterator_type path_begin, iterator_type path_end, visible_type &&visible, output_iterator out) {
+	if(path_begin == path_end) {
+		return out;
+	}
+	iterator_type anchor = path_begin;
+	const iterator_type last = path_end - 1;
+	*out++ = *anchor;
+	while(anchor != last) {
+		const std::ptrdiff_t remaining = last - anchor;
+		std::ptrdiff_t seen = 1;
+		std::ptrdiff_t hidden = 0;
+		for(std::ptrdiff_t probe = 2; seen < remaining; probe *= 2) {
+			const std::ptrdiff_t next = probe < remaining ? probe : remaining;
+			if(!visible(*anchor, anchor[next])) {
+				hidden = next;
+				break;
+			}
+			seen = next;
+		}
+		while(hidden - seen > 1) {
+			const std::ptrdiff_t middle = seen + (hidden - seen) / 2;
+			if(visible(*anchor, anchor[middle])) {
+				seen = middle;
+			}
+			else {
+				hidden = middle;
+			}
+		}
+		anchor += seen;
+		*out++ = *anchor;
+	}
+	return out;
+}
+
+/**
+ * String pulling of a path of cells, see smooth, using the line of sight of @grid.
+ */
+template <typename iterator_type, typename output_iterator>
+output_iterator smooth(const Grid &grid, iterator_type path_begin, iterator_type path_end, output_iterator out) {
+	return smooth(path_begin, path_end, [&grid](const Grid::Index from, const Grid::Index to) {
+		return grid.visible(from, to);
+	}, out);
+}
+
+/**
+ * View of a Grid for any-angle search: the successors of the grid, the Euclidean distance as the heuristic,
+ * which is admissible for paths in any direction, and the line of sight of the grid.
+ *
+ * Models the graph_type of ThetaAStar.
+ */
+class AnyAngleGrid {
+public:
+	typedef Grid::Index Index;
+	typedef Grid::Cost  Cost;
+	
+private:
+	const Grid *grid;
+	
+public:
+	explicit AnyAngleGrid(const Grid &grid): grid(&grid) {}
+	
+	const Grid &base() const {
+		return *grid;
+	}
+	const Index size() const {
+		return grid->size();
+	}
+	const std::uint64_t version() const {
+		return grid->version();
+	}
+	const Index index(std::uint32_t x, std::uint32_t y) const {
+		return grid->index(x, y);
+	}
+	const std::uint32_t x(Index index) const {
+		return grid->x(index);
+	}
+	const std::uint32_t y(Index index) const {
+		return grid->y(index);
+	}
+	
+	/**
+	 * The length of the straight line between the centres of @from and @to.
+	 */
+	const Cost distance(Index from, Index to) const {
+		const Cost dx = Cost(grid->x(from)) - Cost(grid->x(to));
+		const Cost dy = Cost(grid->y(from)) - Cost(grid->y(to));
+		return std::sqrt(dx * dx + dy * dy);
+	}
+	const bool visible(Index from, Index to) const {
+		return grid->visible(from, to);
+	}
+	const Cost heuristic(Index id, Index goal) const {
+		return distance(id, goal);
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		grid->for_each_successor(id, visit);
+	}
+};
+
+/**
+ * Theta*: any-angle search on a grid, finding paths that run straight between their waypoints in any
+ * direction instead of along the grid, without a second smoothing pass.
+ *
+ * Expanding a node, the search tries to reach each successor straight from the predecessor of the node
+ * when the predecessor sees it, and through the node otherwise. The path consists of the waypoints only and
+ * its weight is the sum of the straight distances between them. Expanded nodes are not reopened. The path is
+ * usually shorter than the shortest path along the grid, not always the shortest any-angle path, and costs
+ * a line of sight check per successor.
+ *
+ * Queries are searched by query; start and step search along the grid, as AStarSearch does.
+ *
+ * Template parameters:
+ *   open_list_type:  Open list implementation, BinaryHeapOpenList or MultisetOpenList
+ *   statistics_type: Statistics policy, NoStatistics or SearchStatistics
+ */
+template <template <typename, typename> class open_list_type = BinaryHeapOpenList,
+          typename statistics_type = NoStatistics>
+class ThetaAStar: public AStarSearch<AnyAngleGrid, open_list_type, statistics_type> {
+public:
+	typedef AStarSearch<AnyAngleGrid, open_list_type, statistics_type> Search;
+	typedef typename Search::Index Index;
+	typedef typename Search::Cost  Cost;
+	
+	explicit ThetaAStar(const AnyAngleGrid &grid): Search(grid) {}
+	
+	/**
+	 * Searches the any-angle path from @path_begin to @path_end. Returns if the target was reached.
+	 */
+	const bool query(Index path_begin, Index path_end);
+	const bool query(std::uint32_t begin_x, std::uint32_t begin_y, std::uint32_t end_x, std::uint32_t end_y) {
+		return query(this->graph->index(begin_x, begin_y), this->graph->index(end_x, end_y));
+	}
+};
+
+template <template <typename, typename> class open_list_type, typename statistics_type>
+const bool ThetaAStar<open_list_type, statistics_type>::query(Index path_begin, Index path_end) {
+	this->reset();
+	this->path_begin = path_begin;
+	this->path_end = path_end;
+	this->prepare();
+	while(!this->openList.empty()) {
+		const Index current = this->openList.pop();
+		auto &state = this->states[current];
+		state.closed = true;
+		this->searchStatistics.expand(current, state.g, this->priority(current));
+		if(this->nearest == Search::none || state.h < this->states[this->nearest].h) {
+			this->nearest = current;
+		}
+		if(current == path_end) {
+			this->nearest = current;
+			this->found = true;
+			break;
+		}
+		const Index parent = state.prev;
+		this->graph->for_each_successor(current, [this, current, parent](const Index successor, const Cost cost) {
+			auto &next = this->visit(successor);
+			// Expanded nodes keep their cost: reopening one would leave its successors with costs through its old predecessor
+			if(next.closed) {
+				this->searchStatistics.reject();
+			}
+			else if(parent != Search::none && this->graph->visible(parent, successor)) {
+				this->expand(parent, successor, next, this->graph->distance(parent, successor));
+			}
+			else {
+				this->expand(current, successor, next, cost);
+			}
+		});
+	}
+	this->backlink(this->nearest);
+	return this->found;
+}
+
+#endif
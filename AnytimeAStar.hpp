@@ -0,0 +1,236 @@
+//
+// Anytime repairing A* (ARA*) with deadlines and expansion limits
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_ANYTIMEASTAR_001_HPP
+#define SCU_ANYTIMEASTAR_001_HPP
+
+#include "AStar.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+/**
+ * Anytime search (ARA*) finding a first path quickly with a strongly inflated heuristic, then improving it
+ * with decreasing inflation until it is optimal or the deadline or expansion limit of the query is reached.
+ *
+ * Each improvement continues from the search data of the previous one: only the open nodes and the closed
+ * nodes reached more cheaply since they were expanded are queued again, so every node is expanded at most
+ * once per improvement and the expansions of earlier improvements are not repeated.
+ *
+ * After every completed improvement the path is at most bound() times as long as the shortest path.
+ * The heuristic has to be consistent, as geometric distances are.
+ *
+ * Template parameters:
+ *   graph_type:     See AStarSearch, with a floating point Cost
+ *   open_list_type: Open list implementation, BinaryHeapOpenList or MultisetOpenList
+ *   statistics_type: Statistics policy, NoStatistics or SearchStatistics
+ */
+template <typename graph_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList,
+          typename statistics_type = NoStatistics>
+class AnytimeAStar: public AStarSearch<graph_type, open_list_type, statistics_type> {
+public:
+	typedef AStarSearch<graph_type, open_list_type, statistics_type> Search;
+	typedef typename Search::Index                  Index;
+	typedef typename Search::Cost                   Cost;
+	typedef std::chrono::steady_clock               Clock;
+	
+	static_assert(!std::numeric_limits<Cost>::is_integer,
+	              "AnytimeAStar requires a floating point Cost, the inflation is lowered in fractions");
+	
+private:
+	Cost initial;
+	Cost decrement;
+	Cost suboptimality {std::numeric_limits<Cost>::max()};
+	bool complete {false};
+	std::size_t expansions {0};
+	std::size_t limit {0};
+	Clock::time_point deadline {};
+	
+	std::vector<Index> closedList {};
+	std::vector<Index> inconsistentList {};
+	std::vector<Index> openNodes {};
+	
+	const bool iterate();
+	void repair();
+	void estimate();
+	
+public:
+	/**
+	 * Creates a search starting each query with the inflation @initial, at least 1, reduced by @decrement
+	 * per improvement. A non-positive @decrement lowers the inflation to 1 in the first improvement.
+	 */
+	explicit AnytimeAStar(const graph_type &graph, Cost initial = 3, Cost decrement = 0.5);
+	
+	/**
+	 * Searches the path from @path_begin to @path_end, improving it until it is optimal, @deadline passed
+	 * or @max_expansions nodes were expanded. Returns if a path to the target was found.
+	 */
+	const bool query(Index path_begin, Index path_end,
+					 Clock::time_point deadline = Clock::time_point::max(),
+					 std::size_t max_expansions = std::numeric_limits<std::size_t>::max());
+	/**
+	 * Continues improving the path of the last query until @deadline or another @max_expansions expansions.
+	 * Returns if a path to the target was found.
+	 */
+	const bool improve(Clock::time_point deadline = Clock::time_point::max(),
+					   std::size_t max_expansions = std::numeric_limits<std::size_t>::max());
+	
+	/**
+	 * Factor by which the path found may at most exceed the shortest path, the maximum of Cost before a path was found.
+	 */
+	const Cost bound() const {
+		return suboptimality;
+	}
+	/**
+	 * Returns if the search has finished, with an optimal path or with the target proven unreachable.
+	 */
+	const bool finished() const {
+		return complete;
+	}
+	/**
+	 * The number of expansions of the last query, including all improvements.
+	 */
+	const std::size_t expanded() const {
+		return expansions;
+	}
+};
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+AnytimeAStar<graph_type, open_list_type, statistics_type>::AnytimeAStar(const graph_type &graph, Cost initial, Cost decrement):
+Search(graph), initial(initial >= 1 ? initial : Cost(1)), decrement(decrement > 0 ? decrement : this->initial) {
+	this->inconsistent = &inconsistentList;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const bool AnytimeAStar<graph_type, open_list_type, statistics_type>::query(Index path_begin, Index path_end, Clock::time_point deadline, std::size_t max_expansions) {
+	this->reset();
+	this->path_begin = path_begin;
+	this->path_end = path_end;
+	this->inflation = initial;
+	suboptimality = std::numeric_limits<Cost>::max();
+	complete = false;
+	expansions = 0;
+	closedList.clear();
+	inconsistentList.clear();
+	this->prepare();
+	this->nearest = path_begin;
+	return improve(deadline, max_expansions);
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const bool AnytimeAStar<graph_type, open_list_type, statistics_type>::improve(Clock::time_point deadline, std::size_t max_expansions) {
+	this->deadline = deadline;
+	limit = expansions + std::min(max_expansions, std::numeric_limits<std::size_t>::max() - expansions);
+	while(!complete && iterate()) {
+		estimate();
+		if(this->inflation <= 1 || !this->found) {
+			complete = true;
+		}
+		else {
+			this->inflation = this->inflation - decrement < 1 ? Cost(1) : this->inflation - decrement;
+			repair();
+		}
+	}
+	this->backlink(this->found ? this->path_end : this->nearest);
+	return this->found;
+}
+
+/**
+ * Expands nodes until the target has the lowest priority or the open list is exhausted, returning true,
+ * or until the deadline or expansion limit, returning false.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const bool AnytimeAStar<graph_type, open_list_type, statistics_type>::iterate() {
+	while(!this->openList.empty()) {
+		const Index top = this->openList.top();
+		if(this->visited(this->path_end) && this->states[this->path_end].g <= this->priority(top)) {
+			this->nearest = this->path_end;
+			this->found = true;
+			return true;
+		}
+		if(expansions >= limit || ((expansions & 63) == 0 && Clock::now() >= deadline)) {
+			return false;
+		}
+		const Index current = this->openList.pop();
+		auto &state = this->states[current];
+		state.closed = true;
+		closedList.push_back(current);
+		this->searchStatistics.expand(current, state.g, this->priority(current));
+		if(this->nearest == Search::none || state.h < this->states[this->nearest].h) {
+			this->nearest = current;
+		}
+		++expansions;
+		this->successors(current, std::integral_constant<bool, Search::template PrunesSuccessors<graph_type>::value>());
+	}
+	return true;
+}
+
+/**
+ * Prepares the next improvement: reopens the inconsistent nodes and reorders the open list by the new inflation.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AnytimeAStar<graph_type, open_list_type, statistics_type>::repair() {
+	openNodes.clear();
+	this->openList.for_each([this](const Index id) {
+		openNodes.push_back(id);
+	});
+	this->openList.clear();
+	for(auto id = closedList.begin(); id != closedList.end(); ++id) {
+		this->states[*id].closed = false;
+	}
+	closedList.clear();
+	openNodes.insert(openNodes.end(), inconsistentList.begin(), inconsistentList.end());
+	inconsistentList.clear();
+	for(auto id = openNodes.begin(); id != openNodes.end(); ++id) {
+		if(!this->openList.contains(*id)) {
+			this->openList.push(*id);
+			this->searchStatistics.push(this->openList.size());
+		}
+	}
+}
+
+/**
+ * Computes the suboptimality bound: the inflation, or the ratio of the path cost to the lowest
+ * unexpanded g + h if it is tighter.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void AnytimeAStar<graph_type, open_list_type, statistics_type>::estimate() {
+	if(!this->found) {
+		return;
+	}
+	Cost lowest = std::numeric_limits<Cost>::max();
+	auto visit = [&](const Index id) {
+		const auto &state = this->states[id];
+		lowest = std::min(lowest, state.g + state.h);
+	};
+	this->openList.for_each(visit);
+	for(auto id = inconsistentList.begin(); id != inconsistentList.end(); ++id) {
+		visit(*id);
+	}
+	const Cost cost = this->states[this->path_end].g;
+	suboptimality = this->inflation;
+	if(lowest != std::numeric_limits<Cost>::max() && lowest > 0 && cost / lowest < suboptimality) {
+		suboptimality = cost / lowest < 1 ? Cost(1) : cost / lowest;
+	}
+	if(this->inflation <= 1) {
+		suboptimality = 1;
+	}
+}
+
+#endif
@@ -0,0 +1,305 @@
+//
+// Parallel batches of independent A* queries
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_BATCHASTAR_001_HPP
+#define SCU_BATCHASTAR_001_HPP
+
+#include "AStar.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Solves batches of independent queries against one read-only graph on a pool of worker threads.
+ *
+ * Every worker owns a reusable search of @search_type, so apart from the growth of the path buffer
+ * a batch does not allocate in steady state. The queries of a batch are split into one contiguous
+ * range per worker; a worker running out of queries steals half of the remaining range of another,
+ * so uneven query costs are balanced without a shared queue. The calling thread works as one of the workers.
+ *
+ * The paths of all queries are written into one contiguous buffer, in the order of the queries.
+ *
+ * Template parameters:
+ *   search_type: Search run by the workers, constructible from the graph, such as AStarSearch,
+ *                GridAStar or BidirectionalAStar, or from the graph and further shared arguments,
+ *                such as CachedSearch
+ */
+template <typename search_type>
+class BatchAStar {
+public:
+	typedef search_type             Search;
+	typedef typename Search::Graph  Graph;
+	typedef typename Search::Index  Index;
+	typedef typename Search::Cost   Cost;
+	
+	struct Query {
+		Index begin;
+		Index end;
+	};
+	/**
+	 * Result of a single query. The path occupies [offset, offset + length) of paths().
+	 */
+	struct Result {
+		bool         found {false};
+		Cost         weight {0};
+		std::size_t  offset {0};
+		std::size_t  length {0};
+	};
+	
+private:
+	/**
+	 * Range of query indices [lo, hi) packed into one word, so owner and thieves update it with a single CAS.
+	 */
+	struct Range {
+		std::atomic<std::uint64_t> bounds {0};
+	};
+	/**
+	 * Queries of one part of a batch, the most a Range holds. Larger batches are solved in parts.
+	 */
+	static const std::size_t partSize = 0xffffffff;
+	
+	std::vector<std::unique_ptr<Search>> searches {};
+	std::vector<std::unique_ptr<Range>> ranges {};
+	std::vector<std::vector<Index>> buffers {};
+	std::vector<std::thread> threads {};
+	
+	std::vector<Index> buffer {};
+	std::vector<unsigned int> owners {};
+	
+	const Query *queries {nullptr};
+	Result *results {nullptr};
+	
+	std::mutex mutex {};
+	std::condition_variable wake {};
+	std::condition_variable done {};
+	unsigned int epoch {0};
+	unsigned int pending {0};
+	bool stopping {false};
+	
+	static std::uint64_t pack(std::uint64_t lo, std::uint64_t hi) {
+		return (lo << 32) | hi;
+	}
+	
+	void part(const Query *queries, std::size_t count, Result *results);
+	const bool take(unsigned int self, std::size_t &index);
+	const bool steal(unsigned int self, std::size_t &index);
+	void solve(unsigned int self, std::size_t index);
+	void work(unsigned int self);
+	void loop(unsigned int self);
+	
+public:
+	/**
+	 * Creates a pool of @workers searches on @graph, including the calling thread. Every search is
+	 * constructed from @graph and @shared, such as the PathCache of a CachedSearch.
+	 */
+	template <typename... arguments>
+	explicit BatchAStar(const Graph &graph, unsigned int workers = std::thread::hardware_concurrency(), arguments &...shared);
+	BatchAStar(const BatchAStar &) = delete;
+	BatchAStar &operator=(const BatchAStar &) = delete;
+	~BatchAStar();
+	
+	const unsigned int workers() const {
+		return static_cast<unsigned int>(searches.size());
+	}
+	
+	/**
+	 * Solves the @count @queries and stores their results in @results, which must hold @count elements.
+	 * Blocks until all queries are solved. The paths are valid until the next batch. Batches of 2^32 or
+	 * more queries are solved in parts, each spread over all workers.
+	 */
+	void query(const Query *queries, std::size_t count, Result *results);
+	void query(const std::vector<Query> &queries, std::vector<Result> &results) {
+		results.resize(queries.size());
+		query(queries.data(), queries.size(), results.data());
+	}
+	
+	/**
+	 * The contiguous buffer holding the paths of the last batch.
+	 */
+	const std::vector<Index> &paths() const {
+		return buffer;
+	}
+	const Index *path(const Result &result) const {
+		return buffer.data() + result.offset;
+	}
+};
+
+template <typename search_type>
+template <typename... arguments>
+BatchAStar<search_type>::BatchAStar(const Graph &graph, unsigned int workers, arguments &...shared) {
+	if(workers == 0) {
+		workers = 1;
+	}
+	for(unsigned int self = 0; self < workers; ++self) {
+		searches.emplace_back(new Search(graph, shared...));
+		ranges.emplace_back(new Range());
+	}
+	buffers.resize(workers);
+	for(unsigned int self = 1; self < workers; ++self) {
+		threads.emplace_back(&BatchAStar::loop, this, self);
+	}
+}
+
+template <typename search_type>
+BatchAStar<search_type>::~BatchAStar() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for(auto thread = threads.begin(); thread != threads.end(); ++thread) {
+		thread->join();
+	}
+}
+
+template <typename search_type>
+void BatchAStar<search_type>::query(const Query *queries, std::size_t count, Result *results) {
+	buffer.clear();
+	for(std::size_t first = 0; first < count;) {
+		const std::size_t size = count - first < partSize ? count - first : partSize;
+		part(queries + first, size, results + first);
+		first += size;
+	}
+}
+
+/**
+ * Solves up to partSize queries on all workers and appends their paths to the result buffer.
+ */
+template <typename search_type>
+void BatchAStar<search_type>::part(const Query *queries, std::size_t count, Result *results) {
+	this->queries = queries;
+	this->results = results;
+	owners.resize(count);
+	const std::size_t workers = searches.size();
+	for(std::size_t self = 0; self < workers; ++self) {
+		buffers[self].clear();
+		ranges[self]->bounds.store(pack(count * self / workers, count * (self + 1) / workers));
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending = static_cast<unsigned int>(threads.size());
+		++epoch;
+	}
+	wake.notify_all();
+	work(0);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return pending == 0; });
+	}
+	
+	// Gather the paths of all workers into the contiguous result buffer
+	std::vector<std::size_t> bases(workers, 0);
+	std::size_t total {buffer.size()};
+	for(std::size_t self = 0; self < workers; ++self) {
+		bases[self] = total;
+		total += buffers[self].size();
+	}
+	buffer.resize(total);
+	for(std::size_t self = 0; self < workers; ++self) {
+		std::copy(buffers[self].begin(), buffers[self].end(), buffer.begin() + bases[self]);
+	}
+	for(std::size_t index = 0; index < count; ++index) {
+		results[index].offset += bases[owners[index]];
+	}
+}
+
+template <typename search_type>
+const bool BatchAStar<search_type>::take(unsigned int self, std::size_t &index) {
+	std::atomic<std::uint64_t> &bounds = ranges[self]->bounds;
+	std::uint64_t range = bounds.load();
+	for(;;) {
+		const std::uint64_t lo = range >> 32, hi = range & 0xffffffff;
+		if(lo >= hi) {
+			return false;
+		}
+		if(bounds.compare_exchange_weak(range, pack(lo + 1, hi))) {
+			index = lo;
+			return true;
+		}
+	}
+}
+
+template <typename search_type>
+const bool BatchAStar<search_type>::steal(unsigned int self, std::size_t &index) {
+	const std::size_t workers = searches.size();
+	for(std::size_t offset = 1; offset < workers; ++offset) {
+		std::atomic<std::uint64_t> &bounds = ranges[(self + offset) % workers]->bounds;
+		std::uint64_t range = bounds.load();
+		for(;;) {
+			const std::uint64_t lo = range >> 32, hi = range & 0xffffffff;
+			if(lo >= hi) {
+				break;
+			}
+			const std::uint64_t mid = lo + (hi - lo) / 2;
+			if(bounds.compare_exchange_weak(range, pack(lo, mid))) {
+				ranges[self]->bounds.store(pack(mid + 1, hi));
+				index = mid;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+template <typename search_type>
+void BatchAStar<search_type>::solve(unsigned int self, std::size_t index) {
+	Search &search = *searches[self];
+	std::vector<Index> &paths = buffers[self];
+	Result &result = results[index];
+	result.found = search.query(queries[index].begin, queries[index].end);
+	result.weight = search.weight();
+	result.offset = paths.size();
+	paths.insert(paths.end(), search.begin(), search.end());
+	result.length = paths.size() - result.offset;
+	owners[index] = self;
+}
+
+template <typename search_type>
+void BatchAStar<search_type>::work(unsigned int self) {
+	std::size_t index;
+	while(take(self, index) || steal(self, index)) {
+		solve(self, index);
+	}
+}
+
+template <typename search_type>
+void BatchAStar<search_type>::loop(unsigned int self) {
+	unsigned int seen {0};
+	for(;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, seen] { return stopping || epoch != seen; });
+			if(stopping) {
+				return;
+			}
+			seen = epoch;
+		}
+		work(self);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(--pending == 0) {
+				done.notify_all();
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,982 @@
+//
+// A* graph search and pathfinding benchmark and regression harness
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include "AStar.hpp"
+#include "AnyAngle.hpp"
+#include "AnytimeAStar.hpp"
+#include "BatchAStar.hpp"
+#include "BoundedAStar.hpp"
+#include "DStarLite.hpp"
+#include "GridAStar.hpp"
+#include "HierarchicalAStar.hpp"
+#include "Landmarks.hpp"
+#include "MultiGoal.hpp"
+#include "ParallelAStar.hpp"
+#include "PathCache.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Usage: astar_benchmark [options]
+ *   --sizes 64,256,...  Edge lengths of the generated square maps (default 64,256,1024,4096)
+ *   --queries N         Maximum number of queries per map and engine (default 200)
+ *   --budget SECONDS    Maximum time per map and engine (default 2)
+ *   --multiset N        Largest edge length to run the linear-time MultisetOpenList on (default 256)
+ *   --hierarchical N    Largest edge length to run the near-optimal HierarchicalAStar on (default 1024)
+ *   --landmarks N       Largest edge length to build landmark tables for (default 1024)
+ *   --map FILE          MovingAI .map file to run instead of the generated maps
+ *   --scen FILE         MovingAI .scen file holding the queries and optimal lengths for --map
+ *   --threads N         Workers of the batch engine (default: hardware concurrency)
+ *   --quick             Small maps and few queries, for use as a regression check
+ *
+ * Every engine answers the same queries. Path weights are checked against the reference engine
+ * (GridAStar with the binary heap) and, for scenarios, against the optimal lengths of the .scen file.
+ * HierarchicalAStar, quantised and float costs, weighted A* and ARA* improving its first path for up to one millisecond are suboptimal: their weights
+ * may exceed the reference, their rows report the mean excess.
+ * batch/cached repeats its batch and reports the second pass, answered by a warm PathCache.
+ * theta/heap finds any-angle paths, shorter than the reference: each of its paths is checked to be straight.
+ * dstar/replan repairs every plan after blocking cells on it, reporting the time of all plans of a query.
+ * The exit status is non-zero if any result differs.
+ */
+
+struct Query {
+	Grid::Index begin;
+	Grid::Index end;
+	double optimal;
+};
+
+struct Map {
+	std::string name;
+	Grid grid;
+	std::vector<Query> queries;
+};
+
+struct Options {
+	std::vector<std::uint32_t> sizes {64, 256, 1024, 4096};
+	std::size_t queries {200};
+	double budget {2};
+	std::uint32_t multiset {256};
+	std::uint32_t hierarchical {1024};
+	std::uint32_t landmarks {1024};
+	std::string map {};
+	std::string scen {};
+	unsigned int threads {std::thread::hardware_concurrency()};
+};
+
+/**
+ * Node based representation of a grid, to measure the AStar node interface against the grid engines.
+ */
+class BenchmarkNode: public AStar<BenchmarkNode, std::vector>::NodeBase {
+private:
+	const Grid *grid;
+public:
+	BenchmarkNode(const Grid *grid, Grid::Index index): grid(grid) {
+		id = index;
+		available = !grid->blocked(index);
+	}
+	const double distance(const BenchmarkNode *rhs) const {
+		return grid->heuristic(Grid::Index(id), Grid::Index(rhs->id));
+	}
+	const double heuristic(const BenchmarkNode *rhs) const {
+		return grid->heuristic(Grid::Index(id), Grid::Index(rhs->id));
+	}
+	template <typename Visitor>
+	void for_each_successor(const Iterator &collection_begin, const Iterator &, Visitor &&visit) const {
+		grid->for_each_successor(Grid::Index(id), [&](Grid::Index successor, double) {
+			visit(collection_begin[successor]);
+		});
+	}
+};
+
+/**
+ * Counts the nodes expanded by the last query of a search.
+ */
+template <typename search_type>
+std::size_t expansions(const search_type &search, std::size_t size) {
+	std::size_t count {0};
+	for(std::size_t id = 0; id < size; ++id) {
+		if(search.visited(typename search_type::Index(id)) && search.state(typename search_type::Index(id)).closed) {
+			++count;
+		}
+	}
+	return count;
+}
+
+/**
+ * Adapters giving all engines the same interface for the benchmark.
+ */
+template <typename search_type>
+struct Engine {
+	static const bool exact = true;
+	search_type search;
+	const Grid &grid;
+	template <typename graph_type>
+	Engine(const Grid &grid, const graph_type &graph): search(graph), grid(grid) {}
+	const bool query(const Query &query) {
+		return search.query(query.begin, query.end);
+	}
+	const double weight() const {
+		return search.weight();
+	}
+	const std::size_t expanded() const {
+		return expansions(search, grid.size());
+	}
+	const std::size_t scratch() const {
+		return grid.size() * sizeof(typename search_type::State);
+	}
+};
+template <typename graph_type, template <typename, typename> class open_list_type>
+struct Engine<BidirectionalAStar<graph_type, open_list_type>> {
+	typedef BidirectionalAStar<graph_type, open_list_type> Search;
+	static const bool exact = true;
+	Search search;
+	const Grid &grid;
+	Engine(const Grid &grid, const graph_type &graph): search(graph), grid(grid) {}
+	const bool query(const Query &query) {
+		return search.query(query.begin, query.end);
+	}
+	const double weight() const {
+		return search.weight();
+	}
+	const std::size_t expanded() const {
+		return expansions(search.forward_search(), grid.size()) + expansions(search.backward_search(), grid.size());
+	}
+	const std::size_t scratch() const {
+		return 2 * grid.size() * sizeof(typename Search::Search::State);
+	}
+};
+/**
+ * Searches on nodes, with float costs and 32-bit ids as well. Their weights are summed in double precision,
+ * float costs may still select a path that is longer by their rounding error.
+ */
+template <template <typename, typename> class open_list_type, typename cost_type, typename index_type>
+struct Engine<AStar<BenchmarkNode, std::vector, open_list_type, cost_type, index_type>> {
+	typedef AStar<BenchmarkNode, std::vector, open_list_type, cost_type, index_type> Search;
+	static const bool exact = std::is_same<cost_type, double>::value;
+	std::vector<BenchmarkNode> nodes {};
+	std::vector<BenchmarkNode*> world {};
+	Search *search {nullptr};
+	const Grid &grid;
+	Engine(const Grid &grid, const Grid &): grid(grid) {
+		nodes.reserve(grid.size());
+		for(Grid::Index index = 0; index < grid.size(); ++index) {
+			nodes.push_back(BenchmarkNode(&grid, index));
+		}
+		for(auto &node: nodes) {
+			world.push_back(&node);
+		}
+		search = new Search(world.begin(), world.end());
+	}
+	~Engine() {
+		delete search;
+	}
+	const bool query(const Query &query) {
+		return search->query(world[query.begin], world[query.end]);
+	}
+	const double weight() const {
+		double weight {0};
+		const BenchmarkNode *last {nullptr};
+		for(auto node = search->begin(); node != search->end(); ++node) {
+			if(last) {
+				weight += last->distance(&*node);
+			}
+			last = &*node;
+		}
+		return weight;
+	}
+	const std::size_t expanded() const {
+		return expansions(search->search(), grid.size());
+	}
+	const std::size_t scratch() const {
+		return grid.size() * (sizeof(typename Search::State) + sizeof(BenchmarkNode) + sizeof(BenchmarkNode*));
+	}
+};
+
+template <template <typename, typename> class open_list_type>
+struct Engine<HierarchicalAStar<open_list_type>> {
+	typedef HierarchicalAStar<open_list_type> Search;
+	static const bool exact = false;
+	Search search;
+	const Grid &grid;
+	std::vector<Grid::Index> path {};
+	Engine(const Grid &grid, const Grid &): search(grid), grid(grid) {}
+	const bool query(const Query &query) {
+		const bool found = search.query(query.begin, query.end);
+		path.clear();
+		search.cells(std::back_inserter(path));
+		return found;
+	}
+	const double weight() const {
+		return search.weight();
+	}
+	const std::size_t expanded() const {
+		return expansions(search.abstract_search(), search.nodes());
+	}
+	const std::size_t scratch() const {
+		return search.nodes() * sizeof(typename Search::AbstractSearch::State);
+	}
+};
+
+/**
+ * Searches with costs quantised to 10 and 14, or with float costs. Paths are optimal for the quantised costs
+ * and weighted with the exact costs of their steps, which may exceed the optimum slightly.
+ */
+template <template <typename, typename> class open_list_type, typename cost_type>
+struct Engine<GridAStar<open_list_type, QuantisedGrid<cost_type>>> {
+	typedef GridAStar<open_list_type, QuantisedGrid<cost_type>> Search;
+	static const bool exact = false;
+	Search search;
+	const Grid &grid;
+	Engine(const Grid &grid, const QuantisedGrid<cost_type> &graph): search(graph), grid(grid) {}
+	const bool query(const Query &query) {
+		return search.query(query.begin, query.end);
+	}
+	const double weight() const {
+		double weight {0};
+		for(auto cell = search.begin(); cell != search.end() && cell + 1 != search.end(); ++cell) {
+			weight += grid.x(cell[0]) != grid.x(cell[1]) && grid.y(cell[0]) != grid.y(cell[1]) ? Grid::diagonal() : 1;
+		}
+		return weight;
+	}
+	const std::size_t expanded() const {
+		return expansions(search, grid.size());
+	}
+	const std::size_t scratch() const {
+		return grid.size() * sizeof(typename Search::State);
+	}
+};
+/**
+ * Weighted A* with the heuristic inflated by 2.
+ */
+template <typename graph_type>
+struct WeightedAStar: public AStarSearch<graph_type> {
+	explicit WeightedAStar(const graph_type &graph): AStarSearch<graph_type>(graph) {
+		this->inflate(2);
+	}
+};
+template <typename graph_type>
+struct Engine<WeightedAStar<graph_type>> {
+	static const bool exact = false;
+	WeightedAStar<graph_type> search;
+	const Grid &grid;
+	Engine(const Grid &grid, const graph_type &graph): search(graph), grid(grid) {}
+	const bool query(const Query &query) {
+		return search.query(query.begin, query.end);
+	}
+	const double weight() const {
+		return search.weight();
+	}
+	const std::size_t expanded() const {
+		return expansions(search, grid.size());
+	}
+	const std::size_t scratch() const {
+		return grid.size() * sizeof(typename AStarSearch<graph_type>::State);
+	}
+};
+/**
+ * Search caching its heuristics for repeated targets and deferring them until a node is taken.
+ */
+template <typename graph_type>
+struct DeferredAStar: public AStarSearch<graph_type> {
+	explicit DeferredAStar(const graph_type &graph): AStarSearch<graph_type>(graph) {
+		this->cache(true);
+		this->defer(true);
+	}
+};
+/**
+ * Memory bounded search with a budget of every node, which never prunes and finds the shortest paths.
+ */
+template <typename graph_type>
+struct UnprunedAStar: public BoundedAStar<graph_type> {
+	explicit UnprunedAStar(const graph_type &graph): BoundedAStar<graph_type>(graph, graph.size()) {}
+};
+/**
+ * Search carried out in slices of 256 expansions, as spread over the frames of a game loop.
+ */
+template <typename graph_type>
+struct SlicedAStar: public AStarSearch<graph_type> {
+	explicit SlicedAStar(const graph_type &graph): AStarSearch<graph_type>(graph) {}
+	const bool query(typename graph_type::Index path_begin, typename graph_type::Index path_end) {
+		this->start(path_begin, path_end);
+		while(this->step(256) == AStarSearch<graph_type>::Running) {}
+		return this->successful();
+	}
+};
+/**
+ * A grid as a general CSRGraph with the cell positions for the euclidean heuristic, along with the node
+ * id of every cell, which changes when the nodes are renumbered.
+ */
+struct RenumberedGraph: public CSRGraph<> {
+	std::vector<Index> ids {};
+	
+	explicit RenumberedGraph(const Grid &grid): CSRGraph<>(grid.size(), edges(grid)), ids(grid.size()) {
+		for(Grid::Index cell = 0; cell < grid.size(); ++cell) {
+			place(cell, grid.x(cell), grid.y(cell));
+			ids[cell] = cell;
+		}
+	}
+	static std::vector<Edge> edges(const Grid &grid) {
+		std::vector<Edge> edges;
+		for(Grid::Index cell = 0; cell < grid.size(); ++cell) {
+			if(!grid.blocked(cell)) {
+				grid.for_each_successor(cell, [&](Grid::Index successor, double cost) {
+					edges.push_back({cell, successor, cost});
+				});
+			}
+		}
+		return edges;
+	}
+	void renumber(const std::vector<Index> &order) {
+		const std::vector<Index> renumbered = permute(order);
+		for(auto id = ids.begin(); id != ids.end(); ++id) {
+			*id = renumbered[*id];
+		}
+	}
+};
+template <>
+struct Engine<AStarSearch<RenumberedGraph>> {
+	typedef AStarSearch<RenumberedGraph> Search;
+	static const bool exact = true;
+	Search search;
+	const Grid &grid;
+	const RenumberedGraph &graph;
+	Engine(const Grid &grid, const RenumberedGraph &graph): search(graph), grid(grid), graph(graph) {}
+	const bool query(const Query &query) {
+		return search.query(graph.ids[query.begin], graph.ids[query.end]);
+	}
+	const double weight() const {
+		return search.weight();
+	}
+	const std::size_t expanded() const {
+		return expansions(search, grid.size());
+	}
+	const std::size_t scratch() const {
+		return grid.size() * sizeof(Search::State);
+	}
+};
+/**
+ * Multi-goal search with the target of the query as its only goal.
+ */
+template <typename graph_type, template <typename, typename> class open_list_type>
+struct Engine<MultiGoalAStar<graph_type, open_list_type>> {
+	typedef MultiGoalAStar<graph_type, open_list_type> Search;
+	static const bool exact = true;
+	Search search;
+	const Grid &grid;
+	Engine(const Grid &grid, const graph_type &graph): search(graph), grid(grid) {}
+	const bool query(const Query &query) {
+		return search.query(query.begin, &query.end, &query.end + 1);
+	}
+	const double weight() const {
+		return search.weight();
+	}
+	const std::size_t expanded() const {
+		return expansions(search, grid.size());
+	}
+	const std::size_t scratch() const {
+		return (grid.size() + 1) * sizeof(typename Search::State);
+	}
+};
+/**
+ * Flow field towards the target of every query, read at the start of the query.
+ * Every query sweeps the whole map, its latency is that of a full field.
+ */
+template <typename graph_type, template <typename, typename> class open_list_type>
+struct Engine<FlowField<graph_type, open_list_type>> {
+	typedef FlowField<graph_type, open_list_type> Search;
+	static const bool exact = true;
+	Search field;
+	const Grid &grid;
+	std::vector<double> distances;
+	std::vector<Grid::Index> directions;
+	std::size_t reached {0};
+	Grid::Index begin {0};
+	Engine(const Grid &grid, const graph_type &graph): field(graph), grid(grid), distances(grid.size()), directions(grid.size()) {}
+	const bool query(const Query &query) {
+		reached = field.compute(query.end, distances.data(), directions.data());
+		begin = query.begin;
+		return distances[begin] != std::numeric_limits<double>::max();
+	}
+	const double weight() const {
+		return distances[begin];
+	}
+	const std::size_t expanded() const {
+		return reached;
+	}
+	const std::size_t scratch() const {
+		return grid.size() * (sizeof(AStarSearch<Grid>::State) + sizeof(double) + sizeof(Grid::Index));
+	}
+};
+/**
+ * Hash distributed search of every query on one worker per hardware thread.
+ */
+template <typename graph_type, template <typename, typename> class open_list_type>
+struct Engine<ParallelAStar<graph_type, open_list_type>> {
+	typedef ParallelAStar<graph_type, open_list_type> Search;
+	static const bool exact = true;
+	Search search;
+	const Grid &grid;
+	Engine(const Grid &grid, const graph_type &graph): search(graph), grid(grid) {}
+	const bool query(const Query &query) {
+		return search.query(query.begin, query.end);
+	}
+	const double weight() const {
+		return search.weight();
+	}
+	const std::size_t expanded() const {
+		return search.expansions();
+	}
+	const std::size_t scratch() const {
+		return grid.size() * sizeof(typename Search::State);
+	}
+};
+template <typename graph_type, template <typename, typename> class open_list_type>
+struct Engine<AnytimeAStar<graph_type, open_list_type>> {
+	typedef AnytimeAStar<graph_type, open_list_type> Search;
+	static const bool exact = false;
+	Search search;
+	const Grid &grid;
+	Engine(const Grid &grid, const graph_type &graph): search(graph, 3, 0.5), grid(grid) {}
+	/**
+	 * Improves the path for one millisecond, or until the first path if that takes longer.
+	 */
+	const bool query(const Query &query) {
+		search.query(query.begin, query.end, Search::Clock::now() + std::chrono::milliseconds(1));
+		while(!search.successful() && !search.finished()) {
+			search.improve(Search::Clock::time_point::max(), 1024);
+		}
+		return search.successful();
+	}
+	const double weight() const {
+		return search.weight();
+	}
+	const std::size_t expanded() const {
+		return search.expanded();
+	}
+	const std::size_t scratch() const {
+		return grid.size() * sizeof(typename Search::State);
+	}
+};
+
+const double peak_memory() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0;
+}
+
+/**
+ * Runs the queries of @map on one engine and prints a result row. Returns the number of mismatching weights.
+ */
+template <typename search_type, typename graph_type>
+std::size_t run(const Map &map, const graph_type &graph, const std::string &name,
+				const Options &options, std::vector<double> &reference) {
+	typedef std::chrono::steady_clock Clock;
+	Engine<search_type> engine(map.grid, graph);
+	std::vector<double> latencies;
+	std::size_t expanded {0};
+	std::size_t mismatches {0};
+	double total {0};
+	double excess {0};
+	const bool record = reference.empty();
+	for(std::size_t i = 0; i < map.queries.size() && i < options.queries && total < options.budget; ++i) {
+		const Query &query = map.queries[i];
+		Clock::time_point start = Clock::now();
+		const bool found = engine.query(query);
+		const double latency = std::chrono::duration<double>(Clock::now() - start).count();
+		latencies.push_back(latency);
+		total += latency;
+		expanded += engine.expanded();
+		
+		const double weight = found ? engine.weight() : -1;
+		if(record) {
+			reference.push_back(weight);
+		}
+		const double expected = query.optimal >= 0 ? query.optimal : i < reference.size() ? reference[i] : weight;
+		const double tolerance = query.optimal >= 0 ? 1e-3 * std::max(1.0, expected) : 1e-6;
+		const bool differs = engine.exact ? std::abs(weight - expected) > tolerance :
+		                     (weight < 0) != (expected < 0) || weight < expected - tolerance;
+		if(expected > 0 && weight > 0) {
+			excess += weight / expected - 1;
+		}
+		if(differs) {
+			if(!mismatches) {
+				std::cerr << map.name << " " << name << ": query " << i << " weight " << weight
+				          << " expected " << expected << std::endl;
+			}
+			++mismatches;
+		}
+	}
+	std::sort(latencies.begin(), latencies.end());
+	const std::size_t count = latencies.size();
+	std::cout << std::left << std::setw(22) << map.name << std::setw(18) << name << std::right
+	          << std::setw(8) << count
+	          << std::setw(12) << std::fixed << std::setprecision(1) << (total > 0 ? count / total : 0)
+	          << std::setw(14) << std::setprecision(0) << (total > 0 ? expanded / total : 0)
+	          << std::setw(10) << std::setprecision(1) << (count ? latencies[count / 2] * 1e6 : 0)
+	          << std::setw(10) << (count ? latencies[std::min(count - 1, count * 99 / 100)] * 1e6 : 0)
+	          << std::setw(12) << (count ? double(expanded) / count : 0)
+	          << std::setw(10) << engine.scratch() / (1024.0 * 1024.0)
+	          << std::setw(10) << peak_memory();
+	if(!engine.exact) {
+		std::cout << "  +" << std::setprecision(2) << (count ? std::max(0.0, 100 * excess / count) : 0) << "%";
+	}
+	std::cout << (mismatches ? "  MISMATCH" : "") << std::endl;
+	return mismatches;
+}
+
+/**
+ * Runs the queries answered by the reference engine as one batch on BatchAStar and prints a result row.
+ * The batch is repeated @passes times and the last pass is reported, every search is constructed with @shared.
+ * Latencies are per batch, divided by the number of queries. Returns the number of mismatching weights.
+ */
+template <typename search_type, typename graph_type, typename... arguments>
+std::size_t batch(const Map &map, const graph_type &graph, const std::string &name,
+				  const Options &options, const std::vector<double> &reference,
+				  unsigned int passes = 1, arguments &...shared) {
+	typedef std::chrono::steady_clock Clock;
+	typedef BatchAStar<search_type> Batch;
+	Batch engine(graph, options.threads, shared...);
+	std::vector<typename Batch::Query> queries;
+	std::vector<typename Batch::Result> results;
+	for(std::size_t i = 0; i < reference.size(); ++i) {
+		queries.push_back({map.queries[i].begin, map.queries[i].end});
+	}
+	Clock::time_point start = Clock::now();
+	for(unsigned int pass = 0; pass < passes; ++pass) {
+		start = Clock::now();
+		engine.query(queries, results);
+	}
+	const double total = std::chrono::duration<double>(Clock::now() - start).count();
+	
+	std::size_t mismatches {0};
+	for(std::size_t i = 0; i < results.size(); ++i) {
+		const double weight = results[i].found ? results[i].weight : -1;
+		const bool connected = !results[i].found || (results[i].length && engine.path(results[i])[0] == queries[i].begin);
+		if(std::abs(weight - reference[i]) > 1e-6 || !connected) {
+			if(!mismatches) {
+				std::cerr << map.name << " " << name << ": query " << i << " weight " << weight
+				          << " expected " << reference[i] << std::endl;
+			}
+			++mismatches;
+		}
+	}
+	const std::size_t count = results.size();
+	const double latency = count ? total / count * 1e6 : 0;
+	std::cout << std::left << std::setw(22) << map.name << std::setw(18) << name << std::right
+	          << std::setw(8) << count
+	          << std::setw(12) << std::fixed << std::setprecision(1) << (total > 0 ? count / total : 0)
+	          << std::setw(14) << "-"
+	          << std::setw(10) << std::setprecision(1) << latency
+	          << std::setw(10) << latency
+	          << std::setw(12) << "-"
+	          << std::setw(10) << engine.workers() * map.grid.size() * sizeof(typename search_type::State) / (1024.0 * 1024.0)
+	          << std::setw(10) << peak_memory()
+	          << (mismatches ? "  MISMATCH" : "") << std::endl;
+	return mismatches;
+}
+
+/**
+ * Runs the queries answered by the reference engine on ThetaAStar and prints a result row. Any-angle paths
+ * are shorter than the reference, so each path is checked on its own instead: it has to connect the
+ * query, run straight between visible waypoints, weigh the sum of their distances and be no shorter than
+ * the straight line. Returns the number of failing queries.
+ */
+std::size_t anyangle(const Map &map, const std::string &name, const Options &options, const std::vector<double> &reference) {
+	typedef std::chrono::steady_clock Clock;
+	const AnyAngleGrid grid(map.grid);
+	ThetaAStar<> search(grid);
+	std::vector<double> latencies;
+	std::size_t expanded {0};
+	std::size_t mismatches {0};
+	double total {0};
+	for(std::size_t i = 0; i < reference.size() && total < options.budget; ++i) {
+		const Query &query = map.queries[i];
+		Clock::time_point start = Clock::now();
+		const bool found = search.query(query.begin, query.end);
+		const double latency = std::chrono::duration<double>(Clock::now() - start).count();
+		latencies.push_back(latency);
+		total += latency;
+		expanded += expansions(search, map.grid.size());
+		
+		bool valid = found == (reference[i] >= 0);
+		if(found) {
+			const std::vector<Grid::Index> path(search.begin(), search.end());
+			double length {0};
+			for(std::size_t step = 1; step < path.size(); ++step) {
+				valid = valid && grid.visible(path[step - 1], path[step]);
+				length += grid.distance(path[step - 1], path[step]);
+			}
+			const double tolerance = 1e-6 * std::max(1.0, length);
+			valid = valid && path.front() == query.begin && path.back() == query.end &&
+			        std::abs(search.weight() - length) <= tolerance && length >= grid.distance(query.begin, query.end) - tolerance;
+		}
+		if(!valid) {
+			if(!mismatches) {
+				std::cerr << map.name << " " << name << ": query " << i << " weight " << (found ? search.weight() : -1)
+				          << " is not that of a straight path" << std::endl;
+			}
+			++mismatches;
+		}
+	}
+	std::sort(latencies.begin(), latencies.end());
+	const std::size_t count = latencies.size();
+	std::cout << std::left << std::setw(22) << map.name << std::setw(18) << name << std::right
+	          << std::setw(8) << count
+	          << std::setw(12) << std::fixed << std::setprecision(1) << (total > 0 ? count / total : 0)
+	          << std::setw(14) << std::setprecision(0) << (total > 0 ? expanded / total : 0)
+	          << std::setw(10) << std::setprecision(1) << (count ? latencies[count / 2] * 1e6 : 0)
+	          << std::setw(10) << (count ? latencies[std::min(count - 1, count * 99 / 100)] * 1e6 : 0)
+	          << std::setw(12) << (count ? double(expanded) / count : 0)
+	          << std::setw(10) << map.grid.size() * sizeof(ThetaAStar<>::State) / (1024.0 * 1024.0)
+	          << std::setw(10) << peak_memory()
+	          << (mismatches ? "  MISMATCH" : "") << std::endl;
+	return mismatches;
+}
+
+/**
+ * Runs the queries answered by the reference engine on DStarLite and repairs each plan three times: a
+ * random cell of the planned path is blocked and reported, and the start moves a quarter of the way
+ * along the path. Every plan is checked against the reference, the repaired ones against GridAStar on
+ * the changed map, then the blocked cells are restored. Latencies are those of all plans of a query.
+ * Returns the number of mismatching weights.
+ */
+std::size_t replan(const Map &map, const std::string &name, const Options &options, const std::vector<double> &reference) {
+	typedef std::chrono::steady_clock Clock;
+	Grid grid(map.grid);
+	DStarLite<Grid> planner(grid);
+	GridAStar<> search(grid);
+	std::mt19937 random(11);
+	std::vector<Grid::Index> blocked;
+	std::vector<double> latencies;
+	std::size_t mismatches {0};
+	double total {0};
+	for(std::size_t i = 0; i < reference.size() && total < options.budget; ++i) {
+		Grid::Index begin = map.queries[i].begin;
+		const Grid::Index end = map.queries[i].end;
+		double latency {0};
+		for(unsigned int round = 0; round < 4; ++round) {
+			double expected = reference[i];
+			if(round) {
+				const std::vector<Grid::Index> path(planner.begin(), planner.end());
+				if(path.size() < 3) {
+					break;
+				}
+				blocked.push_back(path[1 + random() % (path.size() - 2)]);
+				grid.block(blocked.back());
+				planner.changed(blocked.back());
+				begin = path[(path.size() - 1) / 4];
+				expected = search.query(begin, end) ? search.weight() : -1;
+			}
+			Clock::time_point start = Clock::now();
+			const bool found = planner.query(begin, end);
+			latency += std::chrono::duration<double>(Clock::now() - start).count();
+			
+			const double weight = found ? planner.weight() : -1;
+			if(std::abs(weight - expected) > 1e-6) {
+				if(!mismatches) {
+					std::cerr << map.name << " " << name << ": query " << i << " round " << round << " weight " << weight
+					          << " expected " << expected << std::endl;
+				}
+				++mismatches;
+			}
+			if(!found) {
+				break;
+			}
+		}
+		for(auto cell = blocked.begin(); cell != blocked.end(); ++cell) {
+			grid.block(*cell, false);
+			planner.changed(*cell);
+		}
+		blocked.clear();
+		latencies.push_back(latency);
+		total += latency;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	const std::size_t count = latencies.size();
+	std::cout << std::left << std::setw(22) << map.name << std::setw(18) << name << std::right
+	          << std::setw(8) << count
+	          << std::setw(12) << std::fixed << std::setprecision(1) << (total > 0 ? count / total : 0)
+	          << std::setw(14) << "-"
+	          << std::setw(10) << std::setprecision(1) << (count ? latencies[count / 2] * 1e6 : 0)
+	          << std::setw(10) << (count ? latencies[std::min(count - 1, count * 99 / 100)] * 1e6 : 0)
+	          << std::setw(12) << "-"
+	          << std::setw(10) << grid.size() * sizeof(DStarLite<Grid>::State) / (1024.0 * 1024.0)
+	          << std::setw(10) << peak_memory()
+	          << (mismatches ? "  MISMATCH" : "") << std::endl;
+	return mismatches;
+}
+
+std::size_t benchmark(const Map &map, const Options &options) {
+	std::vector<double> reference;
+	JumpPointGrid jumpPoints(map.grid);
+	QuantisedGrid<> quantised(map.grid);
+	QuantisedGrid<float> single(map.grid, 1, float(Grid::diagonal()));
+	std::size_t mismatches {0};
+	mismatches += run<GridAStar<BinaryHeapOpenList>>(map, map.grid, "grid/heap", options, reference);
+	if(map.grid.width() <= options.multiset && map.grid.height() <= options.multiset) {
+		mismatches += run<GridAStar<MultisetOpenList>>(map, map.grid, "grid/multiset", options, reference);
+	}
+	mismatches += run<GridAStar<BinaryHeapOpenList, VectorisedGrid>>(map, VectorisedGrid(map.grid), "grid/vectorised", options, reference);
+	mismatches += run<GridAStar<BinaryHeapOpenList, Grid, SearchStatistics>>(map, map.grid, "grid/statistics", options, reference);
+	mismatches += run<GridAStar<BinaryHeapOpenList, JumpPointGrid>>(map, jumpPoints, "jps/heap", options, reference);
+	mismatches += run<GridAStar<BinaryHeapOpenList, QuantisedGrid<>>>(map, quantised, "quantised/heap", options, reference);
+	mismatches += run<GridAStar<BucketOpenList, QuantisedGrid<>>>(map, quantised, "quantised/bucket", options, reference);
+	mismatches += run<GridAStar<BinaryHeapOpenList, QuantisedGrid<float>>>(map, single, "float/heap", options, reference);
+	mismatches += run<BidirectionalAStar<Grid>>(map, map.grid, "bidirectional/heap", options, reference);
+	mismatches += run<AStar<BenchmarkNode, std::vector>>(map, map.grid, "nodes/heap", options, reference);
+	mismatches += run<AStar<BenchmarkNode, std::vector, BinaryHeapOpenList, float, std::uint32_t>>(map, map.grid, "nodes/compact", options, reference);
+	mismatches += run<SlicedAStar<Grid>>(map, map.grid, "sliced/heap", options, reference);
+	mismatches += run<UnprunedAStar<Grid>>(map, map.grid, "bounded/full", options, reference);
+	mismatches += run<WeightedAStar<Grid>>(map, map.grid, "weighted/heap", options, reference);
+	mismatches += run<AnytimeAStar<Grid>>(map, map.grid, "anytime/1ms", options, reference);
+	mismatches += run<ParallelAStar<Grid>>(map, map.grid, "parallel/heap", options, reference);
+	mismatches += run<MultiGoalAStar<Grid>>(map, map.grid, "multigoal/heap", options, reference);
+	if(map.grid.width() <= options.landmarks && map.grid.height() <= options.landmarks) {
+		mismatches += run<FlowField<Grid>>(map, map.grid, "flowfield/heap", options, reference);
+	}
+	{
+		RenumberedGraph roads(map.grid);
+		mismatches += run<AStarSearch<RenumberedGraph>>(map, roads, "csr/heap", options, reference);
+		std::vector<RenumberedGraph::Index> shuffled(roads.ids);
+		std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+		roads.renumber(shuffled);
+		mismatches += run<AStarSearch<RenumberedGraph>>(map, roads, "csr/shuffled", options, reference);
+		roads.renumber(roads.breadth_first_order());
+		mismatches += run<AStarSearch<RenumberedGraph>>(map, roads, "csr/bfs", options, reference);
+		roads.renumber(roads.hilbert_order());
+		mismatches += run<AStarSearch<RenumberedGraph>>(map, roads, "csr/hilbert", options, reference);
+	}
+	if(map.grid.width() <= options.landmarks && map.grid.height() <= options.landmarks) {
+		Landmarks<Grid> precise(map.grid, 8);
+		Landmarks<Grid, std::uint16_t> compact(map.grid, 8);
+		LandmarkGraph<Grid> preciseGraph(map.grid, precise);
+		LandmarkGraph<Grid, std::uint16_t> compactGraph(map.grid, compact);
+		mismatches += run<AStarSearch<LandmarkGraph<Grid>>>(map, preciseGraph, "alt/heap", options, reference);
+		mismatches += run<AStarSearch<LandmarkGraph<Grid, std::uint16_t>>>(map, compactGraph, "alt16/heap", options, reference);
+		mismatches += run<DeferredAStar<LandmarkGraph<Grid>>>(map, preciseGraph, "alt/deferred", options, reference);
+	}
+	if(map.grid.width() <= options.hierarchical && map.grid.height() <= options.hierarchical) {
+		mismatches += run<HierarchicalAStar<>>(map, map.grid, "hierarchical/heap", options, reference);
+	}
+	mismatches += anyangle(map, "theta/heap", options, reference);
+	mismatches += replan(map, "dstar/replan", options, reference);
+	mismatches += batch<GridAStar<BinaryHeapOpenList, JumpPointGrid>>(map, jumpPoints, "batch/jps", options, reference);
+	PathCache<Grid::Index, Grid::Cost> cache(64 * 1024);
+	mismatches += batch<CachedSearch<GridAStar<>>>(map, map.grid, "batch/cached", options, reference, 2, cache);
+	return mismatches;
+}
+
+/**
+ * Generated layouts: open maps without obstacles, maps with randomly blocked cells and perfect mazes
+ * carved by a randomized depth-first search, with corridors of one cell.
+ */
+Map generate(const std::string &layout, std::uint32_t size, double density, std::mt19937 &random) {
+	std::ostringstream name;
+	name << layout << "-" << size;
+	if(layout == "random") {
+		name << "-" << int(density * 100);
+	}
+	Map map {name.str(), Grid(size, size, Grid::Eight), {}};
+	Grid &grid = map.grid;
+	if(layout == "random") {
+		std::bernoulli_distribution blocked(density);
+		for(Grid::Index index = 0; index < grid.size(); ++index) {
+			grid.block(index, blocked(random));
+		}
+	}
+	else if(layout == "maze") {
+		for(Grid::Index index = 0; index < grid.size(); ++index) {
+			grid.block(index);
+		}
+		std::vector<Grid::Index> stack {grid.index(0, 0)};
+		grid.block(stack.back(), false);
+		while(!stack.empty()) {
+			const std::uint32_t x = grid.x(stack.back());
+			const std::uint32_t y = grid.y(stack.back());
+			const int directions[4][2] {{2, 0}, {-2, 0}, {0, 2}, {0, -2}};
+			std::vector<int> candidates;
+			for(int direction = 0; direction < 4; ++direction) {
+				const std::int64_t nx = std::int64_t(x) + directions[direction][0];
+				const std::int64_t ny = std::int64_t(y) + directions[direction][1];
+				if(nx >= 0 && ny >= 0 && nx < size && ny < size && grid.blocked(std::uint32_t(nx), std::uint32_t(ny))) {
+					candidates.push_back(direction);
+				}
+			}
+			if(candidates.empty()) {
+				stack.pop_back();
+				continue;
+			}
+			const int direction = candidates[random() % candidates.size()];
+			grid.block(std::uint32_t(x + directions[direction][0] / 2), std::uint32_t(y + directions[direction][1] / 2), false);
+			stack.push_back(grid.index(std::uint32_t(x + directions[direction][0]), std::uint32_t(y + directions[direction][1])));
+			grid.block(stack.back(), false);
+		}
+	}
+	return map;
+}
+
+void pick(Map &map, std::size_t count, std::mt19937 &random) {
+	std::vector<Grid::Index> walkable;
+	for(Grid::Index index = 0; index < map.grid.size(); ++index) {
+		if(!map.grid.blocked(index)) {
+			walkable.push_back(index);
+		}
+	}
+	if(walkable.empty()) {
+		return;
+	}
+	std::uniform_int_distribution<std::size_t> cell(0, walkable.size() - 1);
+	for(std::size_t i = 0; i < count; ++i) {
+		map.queries.push_back(Query {walkable[cell(random)], walkable[cell(random)], -1});
+	}
+}
+
+/**
+ * Reads a MovingAI benchmark map (https://movingai.com/benchmarks/formats.html).
+ * The cells '.', 'G' and 'S' are walkable, all others are blocked.
+ */
+bool load(Map &map, const std::string &file) {
+	std::ifstream in(file);
+	std::string key, type;
+	std::uint32_t width {0}, height {0};
+	while(in >> key && key != "map") {
+		if(key == "type") in >> type;
+		else if(key == "height") in >> height;
+		else if(key == "width") in >> width;
+	}
+	if(!in || !width || !height) {
+		return false;
+	}
+	map.name = file.substr(file.find_last_of('/') + 1);
+	map.grid = Grid(width, height, Grid::Eight);
+	std::string row;
+	for(std::uint32_t y = 0; y < height && in >> row; ++y) {
+		for(std::uint32_t x = 0; x < width && x < row.size(); ++x) {
+			const char cell = row[x];
+			map.grid.block(x, y, cell != '.' && cell != 'G' && cell != 'S');
+		}
+	}
+	return true;
+}
+
+/**
+ * Reads the queries of a MovingAI scenario file: bucket, map, width, height, start x, start y,
+ * goal x, goal y and optimal length per line.
+ */
+bool scenarios(Map &map, const std::string &file) {
+	std::ifstream in(file);
+	std::string line;
+	while(std::getline(in, line)) {
+		std::istringstream fields(line);
+		std::string bucket, name;
+		std::uint32_t width, height, bx, by, ex, ey;
+		double optimal;
+		if(!(fields >> bucket) || bucket == "version") {
+			continue;
+		}
+		if(fields >> name >> width >> height >> bx >> by >> ex >> ey >> optimal &&
+		   bx < map.grid.width() && ex < map.grid.width() && by < map.grid.height() && ey < map.grid.height()) {
+			map.queries.push_back(Query {map.grid.index(bx, by), map.grid.index(ex, ey), optimal});
+		}
+	}
+	return !map.queries.empty();
+}
+
+std::vector<std::uint32_t> parse(const std::string &list) {
+	std::vector<std::uint32_t> values;
+	std::istringstream in(list);
+	std::string value;
+	while(std::getline(in, value, ',')) {
+		values.push_back(std::uint32_t(std::strtoul(value.c_str(), nullptr, 10)));
+	}
+	return values;
+}
+
+int main(int argc, const char * argv[]) {
+	Options options;
+	for(int i = 1; i < argc; ++i) {
+		const std::string option = argv[i];
+		const bool value = i + 1 < argc;
+		if(option == "--sizes" && value) options.sizes = parse(argv[++i]);
+		else if(option == "--queries" && value) options.queries = std::strtoul(argv[++i], nullptr, 10);
+		else if(option == "--budget" && value) options.budget = std::strtod(argv[++i], nullptr);
+		else if(option == "--multiset" && value) options.multiset = std::uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		else if(option == "--hierarchical" && value) options.hierarchical = std::uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		else if(option == "--landmarks" && value) options.landmarks = std::uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		else if(option == "--map" && value) options.map = argv[++i];
+		else if(option == "--scen" && value) options.scen = argv[++i];
+		else if(option == "--threads" && value) options.threads = unsigned(std::strtoul(argv[++i], nullptr, 10));
+		else if(option == "--quick") {
+			options.sizes = {64, 256};
+			options.queries = 50;
+			options.budget = 1;
+		}
+		else {
+			std::cerr << "Unknown option " << option << std::endl;
+			return 2;
+		}
+	}
+	
+	std::cout << std::left << std::setw(22) << "map" << std::setw(18) << "engine" << std::right
+	          << std::setw(8) << "queries" << std::setw(12) << "queries/s" << std::setw(14) << "expanded/s"
+	          << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(12) << "expanded"
+	          << std::setw(10) << "search MB" << std::setw(10) << "peak MB" << std::endl;
+	
+	std::mt19937 random(20130907);
+	std::size_t mismatches {0};
+	if(!options.map.empty()) {
+		Map map {"", Grid(0, 0), {}};
+		if(!load(map, options.map)) {
+			std::cerr << "Cannot read map " << options.map << std::endl;
+			return 2;
+		}
+		if(options.scen.empty() || !scenarios(map, options.scen)) {
+			pick(map, options.queries, random);
+		}
+		mismatches += benchmark(map, options);
+	}
+	else for(auto size: options.sizes) {
+		const char *layouts[] {"open", "random", "random", "random", "maze"};
+		const double densities[] {0, 0.1, 0.2, 0.3, 0};
+		for(int layout = 0; layout < 5; ++layout) {
+			Map map = generate(layouts[layout], size, densities[layout], random);
+			pick(map, options.queries, random);
+			mismatches += benchmark(map, options);
+		}
+	}
+	
+	if(mismatches) {
+		std::cerr << mismatches << " mismatching results" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,163 @@
+//
+// Memory bounded A* search with a hard limit on the open list
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_BOUNDEDASTAR_001_HPP
+#define SCU_BOUNDEDASTAR_001_HPP
+
+#include "AStar.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A* search holding at most a fixed number of nodes in its open list, so the memory of a query is known
+ * in advance: the search data of AStarSearch, one State per node allocated with the search, and an
+ * open list reserved up front, holding at most budget() entries between expansions and budget() plus the
+ * most successors of a node during one.
+ *
+ * When the open list exceeds the budget, its worst quarter by priority is pruned, in the manner of SMA*.
+ * Pruned nodes keep the cost they were reached with and are queued again only when reached more cheaply,
+ * so pruning trades optimality and completeness for the bound: after pruning, the path may be longer than
+ * the shortest one, and a failed query does not prove the target unreachable, see pruned(). As with
+ * AStarSearch, a failed query results in the path to the node nearest to the target.
+ *
+ * Template parameters:
+ *   graph_type:      See AStarSearch
+ *   open_list_type:  Open list implementation, BinaryHeapOpenList or MultisetOpenList. The BucketOpenList keeps
+ *                    entries of decreased nodes and buckets for all priorities, so its memory is not bounded
+ *   statistics_type: Statistics policy, NoStatistics or SearchStatistics
+ */
+template <typename graph_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList,
+          typename statistics_type = NoStatistics>
+class BoundedAStar: public AStarSearch<graph_type, open_list_type, statistics_type> {
+public:
+	typedef AStarSearch<graph_type, open_list_type, statistics_type> Search;
+	typedef typename Search::Index  Index;
+	typedef typename Search::Cost   Cost;
+	typedef typename Search::Status Status;
+	
+	/**
+	 * Detects the BucketOpenList, whose memory grows with the priorities and decreases instead of the budget.
+	 */
+	template <template <typename, typename> class list_type, typename = void>
+	struct Buckets: std::false_type {};
+	template <typename unused>
+	struct Buckets<BucketOpenList, unused>: std::true_type {};
+	
+	static_assert(!Buckets<open_list_type>::value, "BoundedAStar cannot bound the memory of a BucketOpenList");
+	
+private:
+	std::size_t limit;
+	std::size_t prunings {0};
+	std::vector<Index> survivors {};
+	
+	void prune();
+	
+public:
+	/**
+	 * Creates a search holding at most @budget nodes in its open list, at least 4. @degree is the most
+	 * successors of any node, 8 on grids, for which the open list is reserved beyond the budget.
+	 */
+	BoundedAStar(const graph_type &graph, std::size_t budget, std::size_t degree = 8);
+	
+	/**
+	 * Searches the path from @path_begin to @path_end within the budget. Returns if the target was reached.
+	 */
+	const bool query(Index path_begin, Index path_end);
+	/**
+	 * Begins a query carried out by step, see AStarSearch::start.
+	 */
+	void start(Index path_begin, Index path_end);
+	/**
+	 * Expands up to @max_expansions nodes of the query begun by start within the budget, see AStarSearch::step.
+	 */
+	const Status step(std::size_t max_expansions = std::numeric_limits<std::size_t>::max());
+	
+	const std::size_t budget() const {
+		return limit;
+	}
+	/**
+	 * The number of nodes pruned from the open list by the last query. If none were, the result is that of AStarSearch.
+	 */
+	const std::size_t pruned() const {
+		return prunings;
+	}
+};
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+BoundedAStar<graph_type, open_list_type, statistics_type>::BoundedAStar(const graph_type &graph, std::size_t budget, std::size_t degree):
+Search(graph), limit(std::max<std::size_t>(budget, 4)) {
+	// A node expansion pushes its successors before the budget is checked again
+	this->reserve(limit + degree);
+	survivors.reserve(limit + degree);
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const bool BoundedAStar<graph_type, open_list_type, statistics_type>::query(Index path_begin, Index path_end) {
+	start(path_begin, path_end);
+	step();
+	return this->found;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void BoundedAStar<graph_type, open_list_type, statistics_type>::start(Index path_begin, Index path_end) {
+	Search::start(path_begin, path_end);
+	prunings = 0;
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+const typename BoundedAStar<graph_type, open_list_type, statistics_type>::Status BoundedAStar<graph_type, open_list_type, statistics_type>::step(std::size_t max_expansions) {
+	if(!this->running) {
+		return this->status();
+	}
+	for(std::size_t expansion = 0; expansion < max_expansions; ++expansion) {
+		if(!this->advance()) {
+			this->running = false;
+			this->backlink(this->nearest);
+			break;
+		}
+		if(this->openList.size() > limit) {
+			prune();
+		}
+	}
+	return this->status();
+}
+
+/**
+ * Keeps the best three quarters of the budget in the open list and drops the others. Pruning a quarter at
+ * once keeps the cost of rebuilding the open list constant per queued node.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void BoundedAStar<graph_type, open_list_type, statistics_type>::prune() {
+	survivors.clear();
+	this->openList.for_each([this](const Index id) {
+		survivors.push_back(id);
+	});
+	const std::size_t keep = limit - limit / 4;
+	std::nth_element(survivors.begin(), survivors.begin() + keep, survivors.end(), [this](const Index lhs, const Index rhs) {
+		return this->priority(lhs) < this->priority(rhs);
+	});
+	prunings += survivors.size() - keep;
+	this->openList.clear();
+	for(auto id = survivors.begin(); id != survivors.begin() + keep; ++id) {
+		this->openList.push(*id);
+	}
+}
+
+#endif
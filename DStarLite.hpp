@@ -0,0 +1,360 @@
+//
+// Incremental replanning with D* Lite
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_DSTARLITE_001_HPP
+#define SCU_DSTARLITE_001_HPP
+
+#include "AStar.hpp"
+
+#include <limits>
+#include <vector>
+
+/**
+ * Incremental planner (D* Lite) keeping its search data between queries to the same target.
+ *
+ * The search runs backward from the target, so the distances of all nodes it settled stay valid while the
+ * start moves along the path. When nodes or edges change, only the nodes whose distance is affected are
+ * expanded again by the next query, instead of a whole new search. A query with a different target starts over.
+ *
+ * The graph is read-only to the planner but may change between queries; every change has to be reported
+ * through changed before the next query. The views of AStar::NodeGraph and Grid follow the availability
+ * of their nodes, so changed(id) after toggling a node's available flag or a cell's blocked state suffices,
+ * as the edges from and to the node are those of the node and its neighbours.
+ *
+ * The heuristic estimates the distance from the start through heuristic(id, start), so it has to be
+ * admissible in both directions, as geometric distances are.
+ *
+ * Template parameters:
+ *   graph_type:     See AStarSearch. Directed graphs provide for_each_predecessor, see DirectedGraph.
+ *   open_list_type: Open list implementation, BinaryHeapOpenList or MultisetOpenList
+ */
+template <typename graph_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList>
+class DStarLite {
+public:
+	typedef graph_type            Graph;
+	typedef typename Graph::Index Index;
+	typedef typename Graph::Cost  Cost;
+	typedef typename std::vector<Index>::const_iterator PathIterator;
+	
+	static const Index none;
+	
+	/**
+	 * Search data of a single node: its distance to the target, the one-step lookahead of that distance
+	 * and its priority while it is inconsistent.
+	 */
+	struct State {
+		Cost         g {0};
+		Cost         rhs {0};
+		Cost         primary {0};
+		Cost         secondary {0};
+		unsigned int generation {0};
+		std::size_t  slot {0};
+	};
+	
+private:
+	struct StateAccess {
+		StateAccess(std::vector<State> *states = nullptr): states(states) {}
+		std::vector<State> *states;
+		const bool less(const Index lhs, const Index rhs) const {
+			const State &left = (*states)[lhs];
+			const State &right = (*states)[rhs];
+			return left.primary < right.primary || (left.primary == right.primary && left.secondary < right.secondary);
+		}
+		std::size_t &slot(const Index id) const {
+			return (*states)[id].slot;
+		}};
+	
+	typedef open_list_type<Index, StateAccess> OpenList;
+	
+	const Graph *graph;
+	DirectedGraph<Graph> backwardView;
+	
+	unsigned int generation {0};
+	std::vector<State> states;
+	OpenList openList;
+	
+	Index path_begin {none};
+	Index path_end {none};
+	Cost offset {0};
+	std::vector<Index> path {};
+	
+	static const Cost infinity() {
+		return std::numeric_limits<Cost>::has_infinity ? std::numeric_limits<Cost>::infinity() : std::numeric_limits<Cost>::max();
+	}
+	
+	State &visit(Index id);
+	const Cost priority(Index id, const State &state) const;
+	void key(Index id);
+	const bool before(const State &state, Cost primary, Cost secondary) const;
+	void update(Index id);
+	void calculate();
+	void trace();
+	
+public:
+	explicit DStarLite(const Graph &graph);
+	DStarLite(const DStarLite &) = delete;
+	DStarLite &operator=(const DStarLite &) = delete;
+	
+	/**
+	 * Plans the path from @path_begin to @path_end. If the target is that of the previous query, the
+	 * search data is reused and only repaired where changes were reported. Returns if the target is reachable.
+	 */
+	const bool query(Index path_begin, Index path_end);
+	/**
+	 * Discards all search data, the next query starts over.
+	 */
+	void reset();
+	/**
+	 * Reports that the edges from and to @id changed, such as after a change of its availability.
+	 */
+	void changed(Index id);
+	/**
+	 * Reports that the cost of the edge from @from to @to changed. Both nodes are updated, so on graphs
+	 * treated as undirected the change covers the edge back from @to as well.
+	 */
+	void changed(Index from, Index to);
+	
+	const bool         successful() const;
+	const Cost         weight() const;
+	const unsigned int steps() const;
+	
+	/**
+	 * Returns the search data of @id, valid if the node was reached since the last change of the target.
+	 */
+	const State &state(const Index id) const {
+		return states[id];
+	}
+	const bool visited(const Index id) const {
+		return states[id].generation == generation;
+	}
+	
+	/**
+	 * Iterates over the node ids of the path planned by the last query, from the start to the target.
+	 */
+	const PathIterator begin() const {
+		return path.begin();
+	}
+	const PathIterator end() const {
+		return path.end();
+	}
+};
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+const typename DStarLite<graph_type, open_list_type>::Index DStarLite<graph_type, open_list_type>::none = std::numeric_limits<Index>::max();
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+DStarLite<graph_type, open_list_type>::DStarLite(const Graph &graph):
+graph(&graph), backwardView(graph, true), states(graph.size()), openList(StateAccess(&states)) {
+	
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+void DStarLite<graph_type, open_list_type>::reset() {
+	openList.clear();
+	if(++generation == 0) {
+		for(auto state = states.begin(); state != states.end(); ++state) {
+			state->generation = 0;
+		}
+		++generation;
+	}
+	path_begin = none;
+	path_end = none;
+	offset = 0;
+	path.clear();
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+typename DStarLite<graph_type, open_list_type>::State &DStarLite<graph_type, open_list_type>::visit(Index id) {
+	State &state = states[id];
+	if(state.generation != generation) {
+		state.generation = generation;
+		state.g = infinity();
+		state.rhs = infinity();
+		state.slot = 0;
+	}
+	return state;
+}
+
+/**
+ * Computes the priority of @id from its current distance, the heuristic to the start and the accumulated offset.
+ * Ties are broken by the distance itself, min(g, rhs).
+ */
+template<typename graph_type, template <typename, typename> class open_list_type>
+const typename DStarLite<graph_type, open_list_type>::Cost DStarLite<graph_type, open_list_type>::priority(Index id, const State &state) const {
+	const Cost distance = std::min(state.g, state.rhs);
+	return distance == infinity() ? infinity() : distance + graph->heuristic(id, path_begin) + offset;
+}
+template<typename graph_type, template <typename, typename> class open_list_type>
+void DStarLite<graph_type, open_list_type>::key(Index id) {
+	State &state = states[id];
+	state.primary = priority(id, state);
+	state.secondary = std::min(state.g, state.rhs);
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+const bool DStarLite<graph_type, open_list_type>::before(const State &state, Cost primary, Cost secondary) const {
+	return state.primary < primary || (state.primary == primary && state.secondary < secondary);
+}
+
+/**
+ * Recomputes the lookahead distance of @id from its successors and queues the node if it became inconsistent.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type>
+void DStarLite<graph_type, open_list_type>::update(Index id) {
+	State &state = visit(id);
+	if(id != path_end) {
+		Cost rhs = infinity();
+		graph->for_each_successor(id, [&](const Index successor, const Cost cost) {
+			const State &next = visit(successor);
+			if(next.g != infinity() && next.g + cost < rhs) {
+				rhs = next.g + cost;
+			}
+		});
+		state.rhs = rhs;
+	}
+	if(state.g != state.rhs) {
+		key(id);
+		if(openList.contains(id)) {
+			openList.update(id);
+		}
+		else {
+			openList.push(id);
+		}
+	}
+	else if(openList.contains(id)) {
+		openList.remove(id);
+	}
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+void DStarLite<graph_type, open_list_type>::calculate() {
+	for(;;) {
+		// Settle every node whose priority does not exceed that of the start, including those that only tie
+		// with it up to rounding. Nodes left in the open list can then not lie on a shortest path of the start.
+		const State &start = visit(path_begin);
+		const Cost bound = priority(path_begin, start);
+		const Cost tolerance = bound == infinity() ? Cost(0) : std::numeric_limits<Cost>::epsilon() * 16 * std::max(Cost(1), bound);
+		if(openList.empty() || (states[openList.top()].primary > bound + tolerance && start.rhs == start.g)) {
+			break;
+		}
+		const Index current = openList.top();
+		State &state = states[current];
+		if(before(state, priority(current, state), std::min(state.g, state.rhs))) {
+			// Queued before the start moved, requeue with the current priority
+			key(current);
+			openList.update(current);
+			continue;
+		}
+		openList.pop();
+		if(state.g > state.rhs) {
+			state.g = state.rhs;
+		}
+		else {
+			state.g = infinity();
+			update(current);
+		}
+		backwardView.for_each_successor(current, [&](const Index predecessor, const Cost) {
+			update(predecessor);
+		});
+	}
+}
+
+/**
+ * Follows the cheapest successors from the start to the target.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type>
+void DStarLite<graph_type, open_list_type>::trace() {
+	path.clear();
+	if(visit(path_begin).g == infinity()) {
+		return;
+	}
+	Index current = path_begin;
+	path.push_back(current);
+	while(current != path_end) {
+		Index best = none;
+		Cost cheapest = infinity();
+		graph->for_each_successor(current, [&](const Index successor, const Cost cost) {
+			const State &next = visit(successor);
+			if(next.g != infinity() && next.g + cost < cheapest) {
+				cheapest = next.g + cost;
+				best = successor;
+			}
+		});
+		if(best == none || path.size() > states.size()) {
+			path.clear();
+			return;
+		}
+		current = best;
+		path.push_back(current);
+	}
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+const bool DStarLite<graph_type, open_list_type>::query(Index path_begin, Index path_end) {
+	if(path_end != this->path_end) {
+		reset();
+		this->path_begin = path_begin;
+		this->path_end = path_end;
+		State &goal = visit(path_end);
+		goal.rhs = 0;
+		key(path_end);
+		openList.push(path_end);
+	}
+	else if(path_begin != this->path_begin) {
+		// Keys queued before the move stay lower bounds when raised by the distance moved
+		offset += graph->heuristic(this->path_begin, path_begin);
+		this->path_begin = path_begin;
+	}
+	calculate();
+	trace();
+	return !path.empty();
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+void DStarLite<graph_type, open_list_type>::changed(Index id) {
+	if(path_end == none) {
+		return;
+	}
+	update(id);
+	backwardView.for_each_successor(id, [&](const Index predecessor, const Cost) {
+		update(predecessor);
+	});
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+void DStarLite<graph_type, open_list_type>::changed(Index from, Index to) {
+	if(path_end == none) {
+		return;
+	}
+	update(from);
+	update(to);
+}
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+const bool DStarLite<graph_type, open_list_type>::successful() const {
+	return !path.empty();
+}
+template<typename graph_type, template <typename, typename> class open_list_type>
+const typename DStarLite<graph_type, open_list_type>::Cost DStarLite<graph_type, open_list_type>::weight() const {
+	return path.empty() ? 0 : states[path_begin].g;
+}
+template<typename graph_type, template <typename, typename> class open_list_type>
+const unsigned int DStarLite<graph_type, open_list_type>::steps() const {
+	return path.empty() ? 0 : static_cast<unsigned int>(path.size() - 1);
+}
+
+#endif
@@ -16,6 +16,8 @@
 //
 
 #include "AStar.hpp"
+#include "GridAStar.hpp"
+#include "AnyAngle.hpp"
 #include <deque>
 #include <cmath>
 
@@ -23,6 +25,8 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <iterator>
+#include <vector>
 
 
 // the size of the rectangular graph
@@ -34,7 +38,9 @@ const unsigned int world_height = 10;
  * Simple implementations like this could for example be utilized for tile-collision based 2D games.
  *
  * Note: This node implementation holds no pointers to its neighbours as they are easily computable
- * based on the nodes position and the size of the graph. See @successors and @world1 below for reference.
+ * based on the nodes position and the size of the graph. See @for_each_successor and @world1 below for reference.
+ *
+ * The node functions are resolved statically by AStar, there is no need to declare them virtual.
  *
  * Internal types based on the AStar<node_type, collection_type> template arguments:
  *   Collection (collection_type)
@@ -49,13 +55,25 @@ private:
 public:
 	/**
 	 * Constructor taking the nodes position and if it is occupied.
+	 * The position in the rectangular graph doubles as the nodes dense id.
 	 */
 	MyNode(double x, double y, bool blocked = false):
 	x(x), y(y) {
+		id = x + world_width * y;
 		available = !blocked;
 	}
 	~MyNode() {}
 	
+	/**
+	 * Accessors for the nodes dense id and occupation.
+	 */
+	const std::size_t index() const {
+		return id;
+	}
+	const bool blocked() const {
+		return !available;
+	}
+	
 	/**
 	 * Returns ths real distance between this node and @rhs.
 	 * @rhs is assured to be a neighbour of this node.
@@ -64,7 +82,7 @@ public:
 	 * a constant value of one (1) could be returned here. Therefore the calculation is currently merely implemented
 	 * for demonstration purposes, but it would be required for diagonal node connections/edges.
 	 */
-	virtual const double distance(const MyNode *rhs) const {
+	const double distance(const MyNode *rhs) const {
 		double x_dist = x - rhs->x;
 		double y_dist = y - rhs->y;
 		return std::sqrt(x_dist * x_dist + y_dist * y_dist);
@@ -73,18 +91,19 @@ public:
 	 * Returns ths estimated, heuristic distance between this node and @rhs.
 	 * Must not be greater than the actual path. The linear distance is a common values for this purpose.
 	 */
-	virtual const double heuristic(const MyNode *rhs) const {
+	const double heuristic(const MyNode *rhs) const {
 		// using the above implemented linear distance as heuristic
 		return distance(rhs);
 	}
 	
 	/**
-	 * Returns this nodes successors (or, the nodes this node has active edges to).
+	 * Visits this nodes successors (or, the nodes this node has active edges to).
 	 * The successors in this specific graph are simply the neighbours one unit apart in each direction.
+	 *
+	 * Unlike NodeBase::successors this builds no collection, @visit is called for every successor instead.
 	 */
-	virtual const Collection successors(const Iterator &collection_begin, const Iterator &collection_end) const {
-		Collection ret;
-		
+	template <typename Visitor>
+	void for_each_successor(const Iterator &collection_begin, const Iterator &, Visitor &&visit) const {
 		// Calculate the neighbour positions
 		double en {(x + 1 + world_width * (y    ))}; // Eastern neighbour
 		double wn {(x - 1 + world_width * (y    ))}; // Western neighbour
@@ -92,42 +111,26 @@ public:
 		double nn {(x     + world_width * (y - 1))}; // Northern neighbour
 		
 		// if the calculated neighbours are in the bounds of the graph,
-		// add them to the returned collection.
+		// visit them.
 		if(0 <= en && en < world_height * world_width && x != world_width-1) {
-			auto e = collection_begin [en];
-			ret.push_back(e);
+			visit(collection_begin [en]);
 		}
 		if(0 <= wn && wn < world_height * world_width && x != 0) {
-			auto e = collection_begin [wn];
-			ret.push_back(e);
+			visit(collection_begin [wn]);
 		}
 		if(0 <= sn && sn < world_height * world_width && y != world_height-1) {
-			auto e = collection_begin [sn];
-			ret.push_back(e);
+			visit(collection_begin [sn]);
 		}
-		if(0 <= nn & nn < world_height * world_width && y != 0) {
-			auto e = collection_begin [nn];
-			ret.push_back(e);
+		if(0 <= nn && nn < world_height * world_width && y != 0) {
+			visit(collection_begin [nn]);
 		}
-		
-		return ret;
 	}
 	
 	/**
-	 * Returns if this node equals @rhs. In the graph used in this demonstration,
-	 * a node is simply characterized through its position.
-	 *
-	 * The slightly 'inexact' comparison is required thanks to standard floating-point inaccuracy.
+	 * Convenience function returning a nicely formatted string of the node properties
+	 * and the search data @state the AStar instance holds for this node.
 	 */
-	virtual const bool operator==(const MyNode *rhs) const {
-		return std::abs(x - rhs->x) < std::numeric_limits<double>::epsilon() &&
-		std::abs(y - rhs->y) < std::numeric_limits<double>::epsilon();
-	}
-	
-	/**
-	 * Convenience function returning a nicely formatted string of the node properties.
-	 */
-	virtual const std::string str() const {
+	const std::string str(const AStar<MyNode, std::deque>::State &state) const {
 		std::stringstream ss;
 		ss << std::fixed;
 		ss << std::setprecision(2);
@@ -135,11 +138,11 @@ public:
 		ss << " ";
 		ss << y;
 		ss << " g(";
-		ss << g;
+		ss << state.g;
 		ss << ") h(";
-		ss << h;
+		ss << state.h;
 		ss << ") f(";
-		ss << f;
+		ss << state.g + state.h;
 		ss << ")";
 		return ss.str();
 	}
@@ -190,13 +193,15 @@ int main(int argc, const char * argv[]) {
 		world.push_back(&elem);
 	}
 	
+	// Create a reusable solver for @world
+	AStar<MyNode, std::deque> myAStar(world.begin(), world.end());
+	
 	// Perform the A* search on @world from the upper left to the lower right node
-	AStar<MyNode, std::deque> myAStar(world.begin(), world.end(),
-									  world.begin(), (world.begin()+(world.size()-1)));
+	myAStar.query(world.begin(), (world.begin()+(world.size()-1)));
 	
 	// Output the shortest path
 	for(auto elem: myAStar) {
-		std::cout << elem.str() << std::endl;
+		std::cout << elem.str(myAStar.state(elem)) << std::endl;
 	}
 	if(myAStar.successful())
 		std::cout << "Shortest path found";
@@ -204,6 +209,27 @@ int main(int argc, const char * argv[]) {
 		std::cout << "No existing path to specified target, shortest path to nearest element found";
 	std::cout << " with " << myAStar.weight() << " weight and " << myAStar.steps() << " steps." << std::endl;
 	
+	// Subsequent queries reuse the solvers storage, here searching the way back
+	myAStar.query((world.begin()+(world.size()-1)), world.begin());
+	std::cout << "Way back found with " << myAStar.weight() << " weight and " << myAStar.steps() << " steps." << std::endl;
+	
+	// The same map as a Grid needs no node objects at all
+	Grid grid(world_width, world_height, Grid::Four);
+	for(auto &elem: world1) {
+		grid.block(elem.index(), elem.blocked());
+	}
+	GridAStar<> myGridAStar(grid);
+	myGridAStar.query(0, 0, world_width - 1, world_height - 1);
+	std::cout << "Grid path found with " << myGridAStar.weight() << " weight and " << myGridAStar.steps() << " steps." << std::endl;
+	
+	// Units walking it can skip the cells between those that see each other, or search straight paths right away
+	std::vector<Grid::Index> waypoints;
+	smooth(grid, myGridAStar.begin(), myGridAStar.end(), std::back_inserter(waypoints));
+	std::cout << "Smoothed path has " << waypoints.size() << " waypoints." << std::endl;
+	AnyAngleGrid anyAngle(grid);
+	ThetaAStar<> myThetaAStar(anyAngle);
+	myThetaAStar.query(0, 0, world_width - 1, world_height - 1);
+	std::cout << "Any-angle path found with " << myThetaAStar.weight() << " weight and " << myThetaAStar.steps() << " steps." << std::endl;
 	
 	return 0;
 }
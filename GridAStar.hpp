@@ -0,0 +1,621 @@
+//
+// A* pathfinding on dense rectangular grids
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_GRIDASTAR_001_HPP
+#define SCU_GRIDASTAR_001_HPP
+
+#include "AStar.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+ * Dense rectangular grid of @width * @height cells, addressed by the index x + y * width.
+ *
+ * Blocked cells are stored in a bitmap, all other cells are walkable. The neighbours of a cell are
+ * computed implicitly, so the grid holds no per-cell objects. With Four connectivity cells are
+ * connected to their orthogonal neighbours at a cost of 1. Eight connectivity adds the diagonal
+ * neighbours at a cost of sqrt(2); diagonal moves may not cut the corner of a blocked cell.
+ *
+ * The bitmap is either owned by the grid or a read-only view of memory holding a saved grid, such
+ * as a memory-mapped MapFile. Blocking a cell of a view first copies the bitmap.
+ *
+ * Models the graph_type of AStarSearch.
+ */
+class Grid {
+public:
+	typedef std::uint32_t Index;
+	typedef double        Cost;
+	
+	enum Connectivity {
+		Four = 4,
+		Eight = 8
+	};
+	
+	static constexpr Cost diagonal() {
+		return 1.4142135623730950488;
+	}
+	
+private:
+	std::uint32_t columns;
+	std::uint32_t rows;
+	Connectivity connectivity;
+	std::vector<std::uint64_t> bitmap;
+	const std::uint64_t *words;
+	std::uint64_t changes {0};
+	
+	const std::size_t length() const {
+		return (static_cast<std::size_t>(columns) * rows + 63) / 64;
+	}
+	
+public:
+	Grid(std::uint32_t width, std::uint32_t height, Connectivity connectivity = Eight):
+	columns(width), rows(height), connectivity(connectivity),
+	bitmap(length(), 0), words(bitmap.data()) {}
+	Grid(const Grid &rhs):
+	columns(rhs.columns), rows(rhs.rows), connectivity(rhs.connectivity),
+	bitmap(rhs.bitmap), words(rhs.owned() ? bitmap.data() : rhs.words), changes(rhs.changes) {}
+	Grid(Grid &&rhs) = default;
+	Grid &operator=(const Grid &rhs) {
+		columns = rhs.columns;
+		rows = rhs.rows;
+		connectivity = rhs.connectivity;
+		bitmap = rhs.bitmap;
+		words = rhs.owned() ? bitmap.data() : rhs.words;
+		changes = rhs.changes;
+		return *this;
+	}
+	Grid &operator=(Grid &&rhs) = default;
+	
+	const std::uint32_t width() const {
+		return columns;
+	}
+	const std::uint32_t height() const {
+		return rows;
+	}
+	const Connectivity neighbourhood() const {
+		return connectivity;
+	}
+	const Index size() const {
+		return columns * rows;
+	}
+	
+	const Index index(std::uint32_t x, std::uint32_t y) const {
+		return x + y * columns;
+	}
+	const std::uint32_t x(Index index) const {
+		return index % columns;
+	}
+	const std::uint32_t y(Index index) const {
+		return index / columns;
+	}
+	
+	const bool blocked(Index index) const {
+		return (words[index >> 6] >> (index & 63)) & 1;
+	}
+	const bool blocked(std::uint32_t x, std::uint32_t y) const {
+		return blocked(index(x, y));
+	}
+	void block(Index index, bool blocked = true) {
+		if(this->blocked(index) == blocked) {
+			return;
+		}
+		++changes;
+		if(!owned()) {
+			bitmap.assign(words, words + length());
+			words = bitmap.data();
+		}
+		if(blocked) {
+			bitmap[index >> 6] |= std::uint64_t(1) << (index & 63);
+		}
+		else {
+			bitmap[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+		}
+	}
+	void block(std::uint32_t x, std::uint32_t y, bool blocked = true) {
+		block(index(x, y), blocked);
+	}
+	
+	/**
+	 * Counts the changes of the grid, increased whenever a cell is blocked or unblocked and when the grid
+	 * views other data. Cached paths, see PathCache, stay valid while the version does not change.
+	 */
+	const std::uint64_t version() const {
+		return changes;
+	}
+	/**
+	 * Returns if the grid owns its bitmap, rather than viewing saved data.
+	 */
+	const bool owned() const {
+		return words == bitmap.data();
+	}
+	/**
+	 * Writes the grid to @out: a 16 byte header followed by the bitmap, 8 byte aligned relative to the start.
+	 */
+	const bool save(std::ostream &out) const {
+		const char magic[4] {'G', 'R', 'D', '1'};
+		const std::uint32_t header[3] {columns, rows, std::uint32_t(connectivity)};
+		out.write(magic, sizeof(magic));
+		out.write(reinterpret_cast<const char*>(header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(words), std::streamsize(length() * sizeof(std::uint64_t)));
+		return bool(out);
+	}
+	/**
+	 * Makes the grid a view of the @size bytes at @data, written by save and aligned to 8 bytes.
+	 * The data has to outlive the grid. Returns false if the data is no saved grid, keeping the grid unchanged.
+	 */
+	const bool view(const void *data, std::size_t size) {
+		const char *bytes = static_cast<const char*>(data);
+		std::uint32_t header[3];
+		if(size < 16 || std::memcmp(bytes, "GRD1", 4) != 0) {
+			return false;
+		}
+		std::memcpy(header, bytes + 4, sizeof(header));
+		const std::size_t count = (static_cast<std::size_t>(header[0]) * header[1] + 63) / 64;
+		if(size < 16 + count * sizeof(std::uint64_t) || (header[2] != Four && header[2] != Eight)) {
+			return false;
+		}
+		columns = header[0];
+		rows = header[1];
+		connectivity = Connectivity(header[2]);
+		std::vector<std::uint64_t>().swap(bitmap);
+		words = reinterpret_cast<const std::uint64_t*>(bytes + 16);
+		++changes;
+		return true;
+	}
+	/**
+	 * Returns if the straight line between the centres of @from and @to crosses no blocked cell. The line
+	 * is traced through every cell it touches. Where it passes exactly through a corner, both cells beside
+	 * the corner have to be free, so a line never squeezes between two diagonal blocked cells.
+	 */
+	const bool visible(Index from, Index to) const {
+		std::int64_t cx = x(from);
+		std::int64_t cy = y(from);
+		const std::int64_t dx = x(to) > cx ? std::int64_t(x(to)) - cx : cx - std::int64_t(x(to));
+		const std::int64_t dy = y(to) > cy ? std::int64_t(y(to)) - cy : cy - std::int64_t(y(to));
+		const std::int64_t sx = x(to) > cx ? 1 : -1;
+		const std::int64_t sy = y(to) > cy ? 1 : -1;
+		// The error is the signed distance of the line to the next cell corner, scaled by 2 * dx * dy
+		std::int64_t error = dx - dy;
+		if(blocked(from)) {
+			return false;
+		}
+		for(std::int64_t steps = dx + dy; steps > 0; --steps) {
+			if(error > 0) {
+				cx += sx;
+				error -= 2 * dy;
+			}
+			else if(error < 0) {
+				cy += sy;
+				error += 2 * dx;
+			}
+			else {
+				if(blocked(index(std::uint32_t(cx + sx), std::uint32_t(cy))) || blocked(index(std::uint32_t(cx), std::uint32_t(cy + sy)))) {
+					return false;
+				}
+				cx += sx;
+				cy += sy;
+				error += 2 * dx - 2 * dy;
+				--steps;
+			}
+			if(blocked(index(std::uint32_t(cx), std::uint32_t(cy)))) {
+				return false;
+			}
+		}
+		return true;
+	}
+	
+	/**
+	 * Manhattan distance for Four, octile distance for Eight connectivity.
+	 */
+	const Cost heuristic(Index id, Index goal) const {
+		std::uint32_t dx = x(id) > x(goal) ? x(id) - x(goal) : x(goal) - x(id);
+		std::uint32_t dy = y(id) > y(goal) ? y(id) - y(goal) : y(goal) - y(id);
+		if(connectivity == Four) {
+			return Cost(dx + dy);
+		}
+		std::uint32_t straight = dx > dy ? dx - dy : dy - dx;
+		return Cost(straight) + Cost(dx > dy ? dy : dx) * diagonal();
+	}
+	
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		const std::uint32_t cx = x(id);
+		const std::uint32_t cy = y(id);
+		const bool n = cy > 0           && !blocked(id - columns);
+		const bool s = cy + 1 < rows    && !blocked(id + columns);
+		const bool w = cx > 0           && !blocked(id - 1);
+		const bool e = cx + 1 < columns && !blocked(id + 1);
+		if(n) visit(id - columns, Cost(1));
+		if(s) visit(id + columns, Cost(1));
+		if(w) visit(id - 1, Cost(1));
+		if(e) visit(id + 1, Cost(1));
+		if(connectivity == Eight) {
+			if(n && w && !blocked(id - columns - 1)) visit(id - columns - 1, diagonal());
+			if(n && e && !blocked(id - columns + 1)) visit(id - columns + 1, diagonal());
+			if(s && w && !blocked(id + columns - 1)) visit(id + columns - 1, diagonal());
+			if(s && e && !blocked(id + columns + 1)) visit(id + columns + 1, diagonal());
+		}
+	}
+};
+
+/**
+ * View of a Grid with integral costs, so it can be searched with the BucketOpenList. Straight steps cost
+ * @straight and diagonal steps @diagonal, 10 and 14 by default, approximating 1 and the square root of 2.
+ * The heuristic is the Manhattan or octile distance in the same units, so it stays consistent and
+ * paths are optimal for the quantised costs.
+ *
+ * Models the graph_type of AStarSearch and GridAStar.
+ */
+template <typename cost_type = std::uint32_t>
+class QuantisedGrid {
+public:
+	typedef Grid::Index Index;
+	typedef cost_type   Cost;
+	
+private:
+	const Grid *grid;
+	Cost straight;
+	Cost diagonal;
+	
+public:
+	explicit QuantisedGrid(const Grid &grid, Cost straight = 10, Cost diagonal = 14):
+	grid(&grid), straight(straight), diagonal(diagonal) {}
+	
+	const Index size() const {
+		return grid->size();
+	}
+	const std::uint64_t version() const {
+		return grid->version();
+	}
+	const Index index(std::uint32_t x, std::uint32_t y) const {
+		return grid->index(x, y);
+	}
+	const std::uint32_t x(Index index) const {
+		return grid->x(index);
+	}
+	const std::uint32_t y(Index index) const {
+		return grid->y(index);
+	}
+	/**
+	 * Converts a cost of this view to the units of the grid.
+	 */
+	const Grid::Cost scale(Cost cost) const {
+		return Grid::Cost(cost) / Grid::Cost(straight);
+	}
+	
+	const Cost heuristic(Index id, Index goal) const {
+		const std::uint32_t dx = x(id) > x(goal) ? x(id) - x(goal) : x(goal) - x(id);
+		const std::uint32_t dy = y(id) > y(goal) ? y(id) - y(goal) : y(goal) - y(id);
+		if(grid->neighbourhood() == Grid::Four) {
+			return Cost(dx + dy) * straight;
+		}
+		return Cost(dx > dy ? dx - dy : dy - dx) * straight + Cost(dx > dy ? dy : dx) * diagonal;
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		grid->for_each_successor(id, [&](const Index successor, const Grid::Cost cost) {
+			visit(successor, cost == Grid::Cost(1) ? straight : diagonal);
+		});
+	}
+};
+
+/**
+ * View of a Grid relaxing all neighbours of a cell together. The search takes the open neighbours as a bit
+ * mask, computes the octile or Manhattan heuristics of all of them at once in the vector lanes of Lanes,
+ * and compares their candidate costs to the known costs in the same way, expanding only the neighbours
+ * whose cost improves. Paths, costs and expansions equal those of the Grid itself.
+ *
+ * The per-neighbour loop of the Grid is already inlined into the search, so the gain depends on the map:
+ * open maps with many fresh neighbours per expansion gain, densely blocked maps lose slightly, see the
+ * grid/vectorised row of the benchmark. Compile with AVX enabled for four lanes instead of two.
+ *
+ * Models the graph_type of AStarSearch and GridAStar.
+ */
+class VectorisedGrid {
+public:
+	typedef Grid::Index Index;
+	typedef Grid::Cost  Cost;
+	
+private:
+	const Grid *grid;
+	
+public:
+	explicit VectorisedGrid(const Grid &grid): grid(&grid) {}
+	
+	const Index size() const {
+		return grid->size();
+	}
+	const std::uint64_t version() const {
+		return grid->version();
+	}
+	const Index index(std::uint32_t x, std::uint32_t y) const {
+		return grid->index(x, y);
+	}
+	const std::uint32_t x(Index index) const {
+		return grid->x(index);
+	}
+	const std::uint32_t y(Index index) const {
+		return grid->y(index);
+	}
+	const Cost heuristic(Index id, Index goal) const {
+		return grid->heuristic(id, goal);
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		grid->for_each_successor(id, visit);
+	}
+	/**
+	 * Writes the successors of @id in the order of for_each_successor, together with their costs and
+	 * heuristics to @goal, and returns their number. The heuristics equal those of heuristic.
+	 */
+	const unsigned int neighbourhood(Index id, Index goal, Index (&successors)[8], Cost (&costs)[8], Cost (&heuristics)[8]) const {
+		static const double dxs[8] {0, 0, -1, 1, -1, 1, -1, 1};
+		static const double dys[8] {-1, 1, 0, 0, -1, -1, 1, 1};
+		const std::uint32_t columns = grid->width();
+		const std::uint32_t cx = x(id);
+		const std::uint32_t cy = y(id);
+		const unsigned int n = cy > 0                    && !grid->blocked(id - columns);
+		const unsigned int s = cy + 1 < grid->height()   && !grid->blocked(id + columns);
+		const unsigned int w = cx > 0                    && !grid->blocked(id - 1);
+		const unsigned int e = cx + 1 < columns          && !grid->blocked(id + 1);
+		unsigned int open = n | s << 1 | w << 2 | e << 3;
+		if(grid->neighbourhood() == Grid::Eight) {
+			open |= (n && w && !grid->blocked(id - columns - 1)) << 4 | (n && e && !grid->blocked(id - columns + 1)) << 5 |
+			        (s && w && !grid->blocked(id + columns - 1)) << 6 | (s && e && !grid->blocked(id + columns + 1)) << 7;
+		}
+		
+		// Compacts the open lanes without branching on them: every lane is written, and kept if open
+		const Index offsets[8] {Index(0) - columns, columns, Index(0) - 1, 1,
+		                        Index(0) - columns - 1, Index(0) - columns + 1, columns - 1, columns + 1};
+		const double column = double(cx) - double(x(goal));
+		const double row = double(cy) - double(y(goal));
+		double dx[8] {};
+		double dy[8] {};
+		unsigned int count = 0;
+		for(unsigned int lane = 0; lane < 8; ++lane) {
+			successors[count] = id + offsets[lane];
+			costs[count] = lane < 4 ? Cost(1) : Grid::diagonal();
+			dx[count] = column + dxs[lane];
+			dy[count] = row + dys[lane];
+			count += (open >> lane) & 1;
+		}
+		
+		// Manhattan distance max + min, octile distance (max - min) + min * diagonal, rounded as heuristic
+		const bool octile = grid->neighbourhood() == Grid::Eight;
+		const Lanes::Vector factor = Lanes::broadcast(octile ? Grid::diagonal() : Cost(1));
+		for(unsigned int lane = 0; lane < count; lane += Lanes::width) {
+			const Lanes::Vector across = Lanes::abs(Lanes::load(dx + lane));
+			const Lanes::Vector along = Lanes::abs(Lanes::load(dy + lane));
+			const Lanes::Vector shorter = Lanes::min(across, along);
+			const Lanes::Vector longer = Lanes::max(across, along);
+			Lanes::store(heuristics + lane, Lanes::add(octile ? Lanes::sub(longer, shorter) : longer, Lanes::mul(shorter, factor)));
+		}
+		return count;
+	}
+};
+
+/**
+ * Jump point search view of a Grid. Instead of its direct neighbours, the successors of a cell are
+ * the jump points found by scanning straight and diagonally away from its predecessor, pruning all
+ * paths that are symmetric to another. Only jump points enter the open list, which on open maps
+ * reduces the number of expansions by an order of magnitude while the path cost equals plain A*.
+ *
+ * Implements the variant without corner cutting, matching the moves of Eight connectivity.
+ * With Four connectivity the successors are the plain neighbours of the grid.
+ *
+ * The resulting path consists of jump points, consecutive jump points lie on a straight or diagonal line.
+ * The view holds no data of its own besides a reference to the grid.
+ *
+ * Models the graph_type of AStarSearch.
+ */
+class JumpPointGrid {
+public:
+	typedef Grid::Index Index;
+	typedef Grid::Cost  Cost;
+	
+	static const Index none = ~Index(0);
+	
+private:
+	const Grid *grid;
+	
+	const bool walkable(std::int64_t x, std::int64_t y) const {
+		return x >= 0 && y >= 0 && x < grid->width() && y < grid->height() &&
+		       !grid->blocked(std::uint32_t(x), std::uint32_t(y));
+	}
+	
+	/**
+	 * Scans from (@x, @y) in direction (@dx, @dy), returning the first jump point or none.
+	 * Diagonal scans start a straight scan along both components at every cell.
+	 */
+	const Index jump(std::int64_t x, std::int64_t y, const int dx, const int dy, const Index goal) const {
+		for(;; x += dx, y += dy) {
+			if(!walkable(x, y)) {
+				return none;
+			}
+			const Index index = grid->index(std::uint32_t(x), std::uint32_t(y));
+			if(index == goal) {
+				return index;
+			}
+			if(dx && dy) {
+				if(jump(x + dx, y, dx, 0, goal) != none || jump(x, y + dy, 0, dy, goal) != none) {
+					return index;
+				}
+				if(!walkable(x + dx, y) || !walkable(x, y + dy)) {
+					return none;
+				}
+			}
+			else if(dx) {
+				if((walkable(x, y - 1) && !walkable(x - dx, y - 1)) ||
+				   (walkable(x, y + 1) && !walkable(x - dx, y + 1))) {
+					return index;
+				}
+			}
+			else {
+				if((walkable(x - 1, y) && !walkable(x - 1, y - dy)) ||
+				   (walkable(x + 1, y) && !walkable(x + 1, y - dy))) {
+					return index;
+				}
+			}
+		}
+	}
+	
+	template <typename visitor_type>
+	void scan(const Index id, const int dx, const int dy, const Index goal, visitor_type &visit) const {
+		const Index next = jump(std::int64_t(grid->x(id)) + dx, std::int64_t(grid->y(id)) + dy, dx, dy, goal);
+		if(next != none) {
+			visit(next, grid->heuristic(id, next));
+		}
+	}
+	
+public:
+	explicit JumpPointGrid(const Grid &grid): grid(&grid) {}
+	
+	const Grid &base() const {
+		return *grid;
+	}
+	const Index size() const {
+		return grid->size();
+	}
+	const std::uint64_t version() const {
+		return grid->version();
+	}
+	const Index index(std::uint32_t x, std::uint32_t y) const {
+		return grid->index(x, y);
+	}
+	const std::uint32_t x(Index index) const {
+		return grid->x(index);
+	}
+	const std::uint32_t y(Index index) const {
+		return grid->y(index);
+	}
+	const Cost heuristic(Index id, Index goal) const {
+		return grid->heuristic(id, goal);
+	}
+	
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		grid->for_each_successor(id, visit);
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, Index prev, Index goal, visitor_type &&visit) const {
+		if(grid->neighbourhood() != Grid::Eight) {
+			grid->for_each_successor(id, visit);
+			return;
+		}
+		const std::int64_t x = grid->x(id);
+		const std::int64_t y = grid->y(id);
+		if(prev == none) {
+			for(int dy = -1; dy <= 1; ++dy) for(int dx = -1; dx <= 1; ++dx) {
+				if((dx || dy) && (!dx || !dy || (walkable(x + dx, y) && walkable(x, y + dy)))) {
+					scan(id, dx, dy, goal, visit);
+				}
+			}
+			return;
+		}
+		const std::int64_t px = grid->x(prev);
+		const std::int64_t py = grid->y(prev);
+		const int dx = (x > px) - (x < px);
+		const int dy = (y > py) - (y < py);
+		if(dx && dy) {
+			const bool horizontal = walkable(x + dx, y);
+			const bool vertical = walkable(x, y + dy);
+			if(vertical)               scan(id, 0, dy, goal, visit);
+			if(horizontal)             scan(id, dx, 0, goal, visit);
+			if(horizontal && vertical) scan(id, dx, dy, goal, visit);
+		}
+		else if(dx) {
+			const bool next = walkable(x + dx, y);
+			const bool up = walkable(x, y - 1);
+			const bool down = walkable(x, y + 1);
+			if(next) {
+				scan(id, dx, 0, goal, visit);
+				if(up)   scan(id, dx, -1, goal, visit);
+				if(down) scan(id, dx, 1, goal, visit);
+			}
+			if(up)   scan(id, 0, -1, goal, visit);
+			if(down) scan(id, 0, 1, goal, visit);
+		}
+		else {
+			const bool next = walkable(x, y + dy);
+			const bool left = walkable(x - 1, y);
+			const bool right = walkable(x + 1, y);
+			if(next) {
+				scan(id, 0, dy, goal, visit);
+				if(left)  scan(id, -1, dy, goal, visit);
+				if(right) scan(id, 1, dy, goal, visit);
+			}
+			if(left)  scan(id, -1, 0, goal, visit);
+			if(right) scan(id, 1, 0, goal, visit);
+		}
+	}
+};
+
+/**
+ * A* search on a Grid, running the AStarSearch core loop directly on cell indices.
+ *
+ * All scratch data lives in the contiguous arrays of the search and the bitmap of the grid,
+ * no objects are allocated per cell. Any number of GridAStar instances may search one grid concurrently.
+ *
+ * Template parameters:
+ *   open_list_type: Open list implementation, BinaryHeapOpenList or MultisetOpenList
+ *   grid_type:      Grid, or JumpPointGrid for jump point search
+ *   statistics_type: Statistics policy, NoStatistics or SearchStatistics
+ */
+template <template <typename, typename> class open_list_type = BinaryHeapOpenList,
+          typename grid_type = Grid,
+          typename statistics_type = NoStatistics>
+class GridAStar: public AStarSearch<grid_type, open_list_type, statistics_type> {
+public:
+	typedef AStarSearch<grid_type, open_list_type, statistics_type> Search;
+	typedef typename Search::Index                 Index;
+	
+	explicit GridAStar(const grid_type &grid): Search(grid) {}
+	
+	using Search::query;
+	const bool query(std::uint32_t begin_x, std::uint32_t begin_y, std::uint32_t end_x, std::uint32_t end_y) {
+		return Search::query(this->graph->index(begin_x, begin_y), this->graph->index(end_x, end_y));
+	}
+	
+	/**
+	 * Writes every cell of the resulting path to @out, including the cells between the jump points
+	 * of a jump point search. Returns the iterator past the last written cell.
+	 */
+	template <typename output_iterator>
+	output_iterator cells(output_iterator out) const {
+		auto next = this->begin();
+		if(next == this->end()) {
+			return out;
+		}
+		Index last = *next;
+		*out++ = last;
+		for(++next; next != this->end(); ++next) {
+			const std::int64_t dx = (this->graph->x(*next) > this->graph->x(last)) - (this->graph->x(*next) < this->graph->x(last));
+			const std::int64_t dy = (this->graph->y(*next) > this->graph->y(last)) - (this->graph->y(*next) < this->graph->y(last));
+			const std::int64_t step = dx + dy * std::int64_t(this->graph->index(0, 1));
+			while(last != *next) {
+				last = Index(std::int64_t(last) + step);
+				*out++ = last;
+			}
+		}
+		return out;
+	}
+};
+
+#endif
@@ -0,0 +1,505 @@
+//
+// Hierarchical A* pathfinding on clustered grids
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_HIERARCHICALASTAR_001_HPP
+#define SCU_HIERARCHICALASTAR_001_HPP
+
+#include "AStar.hpp"
+#include "GridAStar.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Hierarchical pathfinding (HPA*) on a Grid.
+ *
+ * The grid is split into square clusters of @extent cells. Along every border between two clusters,
+ * each maximal run of cells walkable on both sides becomes an entrance, with one transition in the middle
+ * of short runs and one at each end of long runs. The cells on both sides of a transition are the nodes of
+ * the abstract graph: they are connected across the border at a cost of 1 and, inside every cluster, to all
+ * other nodes of the cluster at the cost of the shortest path that stays in the cluster. These costs are
+ * precomputed with AStarSearch and cached.
+ *
+ * A query connects start and target to the nodes of their clusters and runs AStarSearch on the abstract graph.
+ * The result is a list of waypoints, only refined into cells when cells is called, one cluster at a time.
+ * The weight is the exact cost of the refined path, which is near-optimal: it is as short as possible
+ * when moving through the transitions, but may be slightly longer than the path found by GridAStar.
+ *
+ * After the blocked state of a cell changed, update rebuilds only the clusters the cell affects.
+ * All scratch data is owned by the instance, so one instance must not be queried concurrently.
+ *
+ * Template parameters:
+ *   open_list_type: Open list implementation, BinaryHeapOpenList or MultisetOpenList
+ */
+template <template <typename, typename> class open_list_type = BinaryHeapOpenList>
+class HierarchicalAStar {
+public:
+	class ClusterView;
+	class AbstractGraph;
+	
+	typedef Grid::Index Index;
+	typedef Grid::Cost  Cost;
+	
+	typedef AStarSearch<ClusterView, open_list_type>   LocalSearch;
+	typedef AStarSearch<AbstractGraph, open_list_type> AbstractSearch;
+	typedef typename std::vector<Index>::const_iterator PathIterator;
+	
+private:
+	struct Edge {
+		std::uint32_t target;
+		Cost          cost;
+	};
+	/**
+	 * Node of the abstract graph, linked to its @partner across the border and by @edges to the nodes of its cluster.
+	 * The ids 0 and 1 are reserved for the start and target of the current query, which have no partner.
+	 */
+	struct Entrance {
+		Index         cell {0};
+		std::uint32_t cluster {0};
+		std::uint32_t border {0};
+		std::uint32_t partner {0};
+		Cost          exit {-1};
+		std::vector<Edge> edges {};
+	};
+	
+	const Grid *grid;
+	std::uint32_t extent;
+	std::uint32_t columns;
+	std::uint32_t rows;
+	
+	std::vector<Entrance> entrances {};
+	std::vector<std::uint32_t> vacant {};
+	std::vector<std::vector<std::uint32_t>> members {};
+	
+	ClusterView view;
+	AbstractGraph graph;
+	LocalSearch local;
+	std::unique_ptr<AbstractSearch> search {};
+	std::size_t capacity {0};
+	
+	std::vector<Index> waypoints {};
+	bool found {false};
+	Cost cost {0};
+	
+	const std::uint32_t cluster(Index cell) const {
+		return grid->x(cell) / extent + grid->y(cell) / extent * columns;
+	}
+	const std::uint32_t add(Index cell, std::uint32_t cluster, std::uint32_t border);
+	void flood(std::uint32_t cluster, Index cell);
+	const Cost distance(Index cell) const;
+	void border(std::uint32_t cluster, bool vertical);
+	void connect(std::uint32_t cluster);
+	
+public:
+	/**
+	 * Creates the abstraction of @grid with clusters of @extent * @extent cells.
+	 */
+	explicit HierarchicalAStar(const Grid &grid, std::uint32_t extent = 16);
+	HierarchicalAStar(const HierarchicalAStar &) = delete;
+	HierarchicalAStar &operator=(const HierarchicalAStar &) = delete;
+	
+	/**
+	 * Rebuilds the entrances and cached paths of all clusters.
+	 */
+	void rebuild();
+	/**
+	 * Rebuilds the clusters affected by a change of the blocked state of @cell: its own cluster and,
+	 * for cells on a cluster border, the entrances of that border and the neighbouring cluster.
+	 */
+	void update(Index cell);
+	void update(std::uint32_t x, std::uint32_t y) {
+		update(grid->index(x, y));
+	}
+	
+	/**
+	 * Searches the path from @path_begin to @path_end, replacing the result of the previous query.
+	 * Returns if the target was reached. Otherwise the waypoints lead to the abstract node nearest to the target.
+	 */
+	const bool query(Index path_begin, Index path_end);
+	const bool query(std::uint32_t begin_x, std::uint32_t begin_y, std::uint32_t end_x, std::uint32_t end_y) {
+		return query(grid->index(begin_x, begin_y), grid->index(end_x, end_y));
+	}
+	
+	const bool successful() const {
+		return found;
+	}
+	const Cost weight() const {
+		return cost;
+	}
+	/**
+	 * The number of abstract nodes of the graph, including the two reserved for start and target.
+	 */
+	const std::size_t nodes() const {
+		return entrances.size();
+	}
+	const AbstractSearch &abstract_search() const {
+		return *search;
+	}
+	
+	/**
+	 * Iterates over the waypoints of the resulting path, the start, the transitions passed and the target.
+	 */
+	const PathIterator begin() const {
+		return waypoints.begin();
+	}
+	const PathIterator end() const {
+		return waypoints.end();
+	}
+	/**
+	 * Refines the waypoints and writes every cell of the resulting path to @out.
+	 * Returns the iterator past the last written cell.
+	 */
+	template <typename output_iterator>
+	output_iterator cells(output_iterator out);
+};
+
+/**
+ * The cells of one cluster as a graph of local ids, the graph_type of the searches inside a cluster.
+ * A flood search ignores the heuristic and reaches every cell of the cluster.
+ */
+template <template <typename, typename> class open_list_type>
+class HierarchicalAStar<open_list_type>::ClusterView {
+	friend HierarchicalAStar;
+private:
+	const Grid *grid;
+	std::uint32_t extent;
+	std::uint32_t left {0};
+	std::uint32_t top {0};
+	std::uint32_t right {0};
+	std::uint32_t bottom {0};
+	bool flood {false};
+	
+	void focus(std::uint32_t cluster, std::uint32_t columns) {
+		left = cluster % columns * extent;
+		top = cluster / columns * extent;
+		right = std::min(left + extent, grid->width());
+		bottom = std::min(top + extent, grid->height());
+	}
+	
+public:
+	typedef Grid::Index Index;
+	typedef Grid::Cost  Cost;
+	
+	ClusterView(const Grid &grid, std::uint32_t extent): grid(&grid), extent(extent) {}
+	
+	const Index size() const {
+		return extent * extent;
+	}
+	const Index local(Index cell) const {
+		return (grid->x(cell) - left) + (grid->y(cell) - top) * extent;
+	}
+	const Index cell(Index id) const {
+		return grid->index(left + id % extent, top + id / extent);
+	}
+	const Cost heuristic(Index id, Index goal) const {
+		return flood ? Cost(0) : grid->heuristic(cell(id), cell(goal));
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		grid->for_each_successor(cell(id), [&](Index successor, Cost cost) {
+			const std::uint32_t x = grid->x(successor);
+			const std::uint32_t y = grid->y(successor);
+			if(x >= left && x < right && y >= top && y < bottom) {
+				visit(local(successor), cost);
+			}
+		});
+	}
+};
+
+/**
+ * The entrances as a graph, the graph_type of the abstract search.
+ */
+template <template <typename, typename> class open_list_type>
+class HierarchicalAStar<open_list_type>::AbstractGraph {
+private:
+	const HierarchicalAStar *layer;
+	
+public:
+	typedef std::uint32_t Index;
+	typedef Grid::Cost    Cost;
+	
+	explicit AbstractGraph(const HierarchicalAStar *layer): layer(layer) {}
+	
+	const Index size() const {
+		return Index(layer->entrances.size());
+	}
+	const Cost heuristic(Index id, Index goal) const {
+		return layer->grid->heuristic(layer->entrances[id].cell, layer->entrances[goal].cell);
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		const Entrance &entrance = layer->entrances[id];
+		if(entrance.partner) {
+			visit(entrance.partner, Cost(1));
+		}
+		for(auto edge = entrance.edges.begin(); edge != entrance.edges.end(); ++edge) {
+			visit(edge->target, edge->cost);
+		}
+		if(entrance.exit >= 0) {
+			visit(Index(1), entrance.exit);
+		}
+	}
+};
+
+template <template <typename, typename> class open_list_type>
+HierarchicalAStar<open_list_type>::HierarchicalAStar(const Grid &grid, std::uint32_t extent):
+grid(&grid), extent(extent ? extent : 1),
+columns((grid.width() + this->extent - 1) / this->extent), rows((grid.height() + this->extent - 1) / this->extent),
+view(grid, this->extent), graph(this), local(view) {
+	rebuild();
+}
+
+template <template <typename, typename> class open_list_type>
+void HierarchicalAStar<open_list_type>::rebuild() {
+	entrances.assign(2, Entrance());
+	vacant.clear();
+	members.assign(columns * rows, std::vector<std::uint32_t>());
+	for(std::uint32_t cluster = 0; cluster < columns * rows; ++cluster) {
+		if(cluster % columns + 1 < columns) {
+			border(cluster, false);
+		}
+		if(cluster / columns + 1 < rows) {
+			border(cluster, true);
+		}
+	}
+	for(std::uint32_t cluster = 0; cluster < columns * rows; ++cluster) {
+		connect(cluster);
+	}
+}
+
+template <template <typename, typename> class open_list_type>
+void HierarchicalAStar<open_list_type>::update(Index cell) {
+	const std::uint32_t home = cluster(cell);
+	const std::uint32_t x = grid->x(cell) % extent;
+	const std::uint32_t y = grid->y(cell) % extent;
+	const std::uint32_t cx = home % columns;
+	const std::uint32_t cy = home / columns;
+	if(x + 1 == extent && cx + 1 < columns) {
+		border(home, false);
+		connect(home + 1);
+	}
+	if(x == 0 && cx > 0) {
+		border(home - 1, false);
+		connect(home - 1);
+	}
+	if(y + 1 == extent && cy + 1 < rows) {
+		border(home, true);
+		connect(home + columns);
+	}
+	if(y == 0 && cy > 0) {
+		border(home - columns, true);
+		connect(home - columns);
+	}
+	connect(home);
+}
+
+template <template <typename, typename> class open_list_type>
+const std::uint32_t HierarchicalAStar<open_list_type>::add(Index cell, std::uint32_t cluster, std::uint32_t border) {
+	std::uint32_t id;
+	if(!vacant.empty()) {
+		id = vacant.back();
+		vacant.pop_back();
+	}
+	else {
+		id = std::uint32_t(entrances.size());
+		entrances.push_back(Entrance());
+	}
+	Entrance &entrance = entrances[id];
+	entrance.cell = cell;
+	entrance.cluster = cluster;
+	entrance.border = border;
+	entrance.partner = 0;
+	entrance.exit = -1;
+	entrance.edges.clear();
+	members[cluster].push_back(id);
+	return id;
+}
+
+/**
+ * Searches every cell of @cluster reachable from @cell inside the cluster, see distance.
+ */
+template <template <typename, typename> class open_list_type>
+void HierarchicalAStar<open_list_type>::flood(std::uint32_t cluster, Index cell) {
+	view.focus(cluster, columns);
+	view.flood = true;
+	local.query(view.local(cell), view.size());
+	view.flood = false;
+}
+
+/**
+ * The cost of the shortest path to @cell found by the last flood, or a negative value if it was not reached.
+ */
+template <template <typename, typename> class open_list_type>
+const typename HierarchicalAStar<open_list_type>::Cost HierarchicalAStar<open_list_type>::distance(Index cell) const {
+	const Index id = view.local(cell);
+	if(!local.visited(id) || !local.state(id).closed) {
+		return -1;
+	}
+	return local.state(id).g;
+}
+
+/**
+ * Replaces the entrances of the border between @cluster and its right or, if @vertical, its lower neighbour.
+ */
+template <template <typename, typename> class open_list_type>
+void HierarchicalAStar<open_list_type>::border(std::uint32_t cluster, bool vertical) {
+	const std::uint32_t neighbour = vertical ? cluster + columns : cluster + 1;
+	const std::uint32_t id = cluster * 2 + vertical;
+	for(const std::uint32_t side: {cluster, neighbour}) {
+		std::vector<std::uint32_t> &nodes = members[side];
+		for(std::size_t index = nodes.size(); index-- > 0;) {
+			if(entrances[nodes[index]].border == id) {
+				entrances[nodes[index]].edges.clear();
+				entrances[nodes[index]].partner = 0;
+				vacant.push_back(nodes[index]);
+				nodes.erase(nodes.begin() + index);
+			}
+		}
+	}
+	
+	// Walk along the border, the cells of the cluster at (x, y) and of the neighbour one step across
+	const std::uint32_t cx = cluster % columns * extent;
+	const std::uint32_t cy = cluster / columns * extent;
+	const std::uint32_t x = vertical ? cx : std::min(cx + extent, grid->width()) - 1;
+	const std::uint32_t y = vertical ? std::min(cy + extent, grid->height()) - 1 : cy;
+	const std::uint32_t length = vertical ? std::min(cx + extent, grid->width()) - cx : std::min(cy + extent, grid->height()) - cy;
+	const Index along = vertical ? grid->index(1, 0) : grid->index(0, 1);
+	const Index across = vertical ? grid->index(0, 1) : grid->index(1, 0);
+	const Index first = grid->index(x, y);
+	const std::uint32_t split = 6;
+	
+	auto transition = [&](std::uint32_t offset) {
+		const Index inside = first + offset * along;
+		const std::uint32_t lhs = add(inside, cluster, id);
+		const std::uint32_t rhs = add(inside + across, neighbour, id);
+		entrances[lhs].partner = rhs;
+		entrances[rhs].partner = lhs;
+	};
+	std::uint32_t start = 0;
+	for(std::uint32_t offset = 0; offset <= length; ++offset) {
+		const Index inside = first + offset * along;
+		if(offset < length && !grid->blocked(inside) && !grid->blocked(inside + across)) {
+			continue;
+		}
+		if(offset > start) {
+			if(offset - start < split) {
+				transition(start + (offset - start) / 2);
+			}
+			else {
+				transition(start);
+				transition(offset - 1);
+			}
+		}
+		start = offset + 1;
+	}
+}
+
+/**
+ * Recomputes the cached paths between all nodes of @cluster.
+ */
+template <template <typename, typename> class open_list_type>
+void HierarchicalAStar<open_list_type>::connect(std::uint32_t cluster) {
+	const std::vector<std::uint32_t> &nodes = members[cluster];
+	for(auto node = nodes.begin(); node != nodes.end(); ++node) {
+		entrances[*node].edges.clear();
+		flood(cluster, entrances[*node].cell);
+		for(auto other = nodes.begin(); other != nodes.end(); ++other) {
+			const Cost cost = distance(entrances[*other].cell);
+			if(other != node && cost >= 0) {
+				entrances[*node].edges.push_back({*other, cost});
+			}
+		}
+	}
+}
+
+template <template <typename, typename> class open_list_type>
+const bool HierarchicalAStar<open_list_type>::query(Index path_begin, Index path_end) {
+	waypoints.clear();
+	found = false;
+	cost = 0;
+	if(grid->blocked(path_begin) || grid->blocked(path_end)) {
+		return false;
+	}
+	if(!search || capacity != entrances.size()) {
+		search.reset(new AbstractSearch(graph));
+		capacity = entrances.size();
+	}
+	
+	// Connect the start and target to the nodes of their clusters
+	Entrance &start = entrances[0];
+	Entrance &goal = entrances[1];
+	start.cell = path_begin;
+	start.cluster = cluster(path_begin);
+	start.edges.clear();
+	goal.cell = path_end;
+	goal.cluster = cluster(path_end);
+	goal.edges.clear();
+	flood(start.cluster, path_begin);
+	for(auto node = members[start.cluster].begin(); node != members[start.cluster].end(); ++node) {
+		const Cost cost = distance(entrances[*node].cell);
+		if(cost >= 0) {
+			start.edges.push_back({*node, cost});
+		}
+	}
+	if(start.cluster == goal.cluster && distance(path_end) >= 0) {
+		start.edges.push_back({1, distance(path_end)});
+	}
+	flood(goal.cluster, path_end);
+	for(auto node = members[goal.cluster].begin(); node != members[goal.cluster].end(); ++node) {
+		entrances[*node].exit = distance(entrances[*node].cell);
+	}
+	
+	search->query(0, 1);
+	
+	for(auto node = members[goal.cluster].begin(); node != members[goal.cluster].end(); ++node) {
+		entrances[*node].exit = -1;
+	}
+	found = search->successful();
+	cost = search->weight();
+	for(auto node = search->begin(); node != search->end(); ++node) {
+		if(waypoints.empty() || waypoints.back() != entrances[*node].cell) {
+			waypoints.push_back(entrances[*node].cell);
+		}
+	}
+	return found;
+}
+
+template <template <typename, typename> class open_list_type>
+template <typename output_iterator>
+output_iterator HierarchicalAStar<open_list_type>::cells(output_iterator out) {
+	if(waypoints.empty()) {
+		return out;
+	}
+	*out++ = waypoints.front();
+	for(std::size_t index = 1; index < waypoints.size(); ++index) {
+		const Index from = waypoints[index - 1];
+		const Index to = waypoints[index];
+		if(cluster(from) != cluster(to)) {
+			*out++ = to;
+			continue;
+		}
+		view.focus(cluster(from), columns);
+		local.query(view.local(from), view.local(to));
+		auto node = local.begin();
+		for(++node; node != local.end(); ++node) {
+			*out++ = view.cell(*node);
+		}
+	}
+	return out;
+}
+
+#endif
@@ -0,0 +1,368 @@
+//
+// Landmark (ALT) heuristics from precomputed distance tables
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_LANDMARKS_001_HPP
+#define SCU_LANDMARKS_001_HPP
+
+#include "AStar.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+/**
+ * Distance tables of a few landmark nodes, providing a lower bound of the distance between any two nodes
+ * by the triangle inequality: for every landmark L, dist(id, goal) >= |dist(L, goal) - dist(L, id)|.
+ *
+ * On maps with obstacles, mazes in particular, this bound is far tighter than geometric distances. The
+ * landmarks are chosen by farthest-point selection: the first is the node farthest from @seed, every further
+ * landmark is the node farthest from all landmarks chosen so far. Their distances to all nodes are computed
+ * once with AStarSearch, searching the whole graph without a target.
+ *
+ * The tables are stored node by node as @distance_type. Floating point types keep the distances as they are,
+ * unsigned integer types quantise them to steps of maximum distance / (max - 1), trading a slightly weaker bound
+ * for a fraction of the memory. The bound is reduced by one rounding step, so it stays admissible.
+ *
+ * The graph is treated as undirected. The tables can be written to a stream and loaded again at startup,
+ * or used in place as a read-only view of saved tables, such as those of a memory-mapped MapFile.
+ *
+ * Template parameters:
+ *   graph_type:    See AStarSearch
+ *   distance_type: Table entry type, such as float or std::uint16_t
+ */
+template <typename graph_type, typename distance_type = float>
+class Landmarks {
+public:
+	typedef graph_type            Graph;
+	typedef typename Graph::Index Index;
+	typedef typename Graph::Cost  Cost;
+	typedef distance_type         Distance;
+	
+private:
+	/**
+	 * View of the graph without heuristic, so a search visits the nodes in order of their distance.
+	 */
+	struct Flood {
+		typedef typename Graph::Index Index;
+		typedef typename Graph::Cost  Cost;
+		const Graph *graph;
+		const Index size() const {
+			return graph->size();
+		}
+		const Cost heuristic(Index, Index) const {
+			return Cost(0);
+		}
+		template <typename visitor_type>
+		void for_each_successor(Index id, visitor_type &&visit) const {
+			graph->for_each_successor(id, visit);
+		}};
+	
+	static const bool floating = std::numeric_limits<Distance>::is_iec559;
+	
+	std::vector<Index> landmarks {};
+	std::vector<Distance> table {};
+	const Distance *entries {nullptr};
+	std::size_t nodes {0};
+	double scale {1};
+	
+	static const Distance unreachable() {
+		return floating ? std::numeric_limits<Distance>::infinity() : std::numeric_limits<Distance>::max();
+	}
+	void distances(AStarSearch<Flood> &search, Index landmark, std::vector<Cost> &costs) const;
+	
+public:
+	/**
+	 * Creates empty tables, to be loaded.
+	 */
+	Landmarks() {}
+	/**
+	 * Chooses @count landmarks on @graph and computes their distance tables.
+	 */
+	Landmarks(const Graph &graph, unsigned int count, Index seed = 0);
+	Landmarks(const Landmarks &rhs):
+	landmarks(rhs.landmarks), table(rhs.table), entries(rhs.owned() ? table.data() : rhs.entries),
+	nodes(rhs.nodes), scale(rhs.scale) {}
+	Landmarks &operator=(const Landmarks &rhs) {
+		landmarks = rhs.landmarks;
+		table = rhs.table;
+		entries = rhs.owned() ? table.data() : rhs.entries;
+		nodes = rhs.nodes;
+		scale = rhs.scale;
+		return *this;
+	}
+	
+	const unsigned int count() const {
+		return static_cast<unsigned int>(landmarks.size());
+	}
+	const Index landmark(unsigned int index) const {
+		return landmarks[index];
+	}
+	/**
+	 * The memory held by the distance tables in bytes.
+	 */
+	const std::size_t memory() const {
+		return nodes * landmarks.size() * sizeof(Distance);
+	}
+	/**
+	 * Returns if the tables are owned, rather than viewing saved data.
+	 */
+	const bool owned() const {
+		return entries == table.data();
+	}
+	
+	/**
+	 * Lower bound of the distance between @id and @goal, zero if no landmark reaches both.
+	 */
+	const Cost heuristic(Index id, Index goal) const;
+	
+	/**
+	 * Writes the tables to @out. Returns if the stream is still good.
+	 */
+	const bool save(std::ostream &out) const;
+	/**
+	 * Replaces the tables by those read from @in, written by save with the same distance_type.
+	 * Returns false if the data does not match, keeping the previous tables.
+	 */
+	const bool load(std::istream &in);
+	/**
+	 * Makes the tables a view of the @size bytes at @data, written by save with the same distance_type and
+	 * aligned to 8 bytes, as the sections of a MapFile are. The data has to outlive the tables. Returns
+	 * false if the data does not match or its table is not aligned for distance_type.
+	 */
+	const bool view(const void *data, std::size_t size);
+};
+
+template <typename graph_type, typename distance_type>
+Landmarks<graph_type, distance_type>::Landmarks(const Graph &graph, unsigned int count, Index seed):
+nodes(graph.size()) {
+	if(nodes == 0 || count == 0) {
+		return;
+	}
+	Flood flood {&graph};
+	AStarSearch<Flood> search(flood);
+	std::vector<std::vector<Cost>> rows(count);
+	std::vector<Cost> nearest(nodes, std::numeric_limits<Cost>::max());
+	
+	// The farthest node from the seed, then the farthest from all landmarks chosen so far
+	std::vector<Cost> costs;
+	distances(search, seed, costs);
+	Cost maximum {0};
+	for(unsigned int index = 0; index < count; ++index) {
+		Index next = seed;
+		Cost farthest {0};
+		for(std::size_t id = 0; id < nodes; ++id) {
+			const Cost cost = index == 0 ? costs[id] : nearest[id];
+			if(cost != std::numeric_limits<Cost>::max() && (next == seed || cost > farthest)) {
+				farthest = cost;
+				next = Index(id);
+			}
+		}
+		landmarks.push_back(next);
+		distances(search, next, rows[index]);
+		for(std::size_t id = 0; id < nodes; ++id) {
+			const Cost cost = rows[index][id];
+			if(cost != std::numeric_limits<Cost>::max()) {
+				nearest[id] = std::min(nearest[id], cost);
+				maximum = std::max(maximum, cost);
+			}
+		}
+	}
+	
+	if(!floating) {
+		scale = maximum > 0 ? double(maximum) / double(std::numeric_limits<Distance>::max() - 1) : 1;
+	}
+	table.resize(nodes * count);
+	entries = table.data();
+	for(std::size_t id = 0; id < nodes; ++id) {
+		for(unsigned int index = 0; index < count; ++index) {
+			const Cost cost = rows[index][id];
+			table[id * count + index] = cost == std::numeric_limits<Cost>::max() ? unreachable() : Distance(double(cost) / scale);
+		}
+	}
+}
+
+/**
+ * Stores the distance from @landmark to every node in @costs, the maximum of Cost for unreachable nodes.
+ */
+template <typename graph_type, typename distance_type>
+void Landmarks<graph_type, distance_type>::distances(AStarSearch<Flood> &search, Index landmark, std::vector<Cost> &costs) const {
+	search.query(landmark, Index(nodes));
+	costs.assign(nodes, std::numeric_limits<Cost>::max());
+	for(std::size_t id = 0; id < nodes; ++id) {
+		if(search.visited(Index(id)) && search.state(Index(id)).closed) {
+			costs[id] = search.state(Index(id)).g;
+		}
+	}
+}
+
+template <typename graph_type, typename distance_type>
+const typename Landmarks<graph_type, distance_type>::Cost Landmarks<graph_type, distance_type>::heuristic(Index id, Index goal) const {
+	const std::size_t count = landmarks.size();
+	const Distance *from = entries + std::size_t(id) * count;
+	const Distance *to = entries + std::size_t(goal) * count;
+	double bound {0};
+	for(std::size_t index = 0; index < count; ++index) {
+		if(from[index] == unreachable() || to[index] == unreachable()) {
+			continue;
+		}
+		const double lhs = double(from[index]);
+		const double rhs = double(to[index]);
+		// Both entries may be rounded by one step, in opposite directions
+		const double slack = floating ? 2 * std::numeric_limits<Distance>::epsilon() * std::max(lhs, rhs) : 1;
+		const double difference = (lhs > rhs ? lhs - rhs : rhs - lhs) - slack;
+		bound = std::max(bound, difference);
+	}
+	return Cost(bound * scale);
+}
+
+template <typename graph_type, typename distance_type>
+const bool Landmarks<graph_type, distance_type>::save(std::ostream &out) const {
+	// The header is padded to 32 bytes, so the table after the 8-byte ids is aligned for any distance_type
+	const char magic[4] {'A', 'L', 'T', '2'};
+	const char padding[4] {};
+	const std::uint32_t width = sizeof(Distance);
+	const std::uint32_t count = std::uint32_t(landmarks.size());
+	const std::uint64_t size = nodes;
+	out.write(magic, sizeof(magic));
+	out.write(reinterpret_cast<const char*>(&width), sizeof(width));
+	out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+	out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	out.write(reinterpret_cast<const char*>(&scale), sizeof(scale));
+	out.write(padding, sizeof(padding));
+	for(auto landmark = landmarks.begin(); landmark != landmarks.end(); ++landmark) {
+		const std::uint64_t id = *landmark;
+		out.write(reinterpret_cast<const char*>(&id), sizeof(id));
+	}
+	out.write(reinterpret_cast<const char*>(entries), std::streamsize(memory()));
+	return bool(out);
+}
+
+template <typename graph_type, typename distance_type>
+const bool Landmarks<graph_type, distance_type>::load(std::istream &in) {
+	char magic[4] {};
+	std::uint32_t width {0};
+	std::uint32_t count {0};
+	std::uint64_t size {0};
+	double factor {1};
+	in.read(magic, sizeof(magic));
+	in.read(reinterpret_cast<char*>(&width), sizeof(width));
+	in.read(reinterpret_cast<char*>(&count), sizeof(count));
+	in.read(reinterpret_cast<char*>(&size), sizeof(size));
+	in.read(reinterpret_cast<char*>(&factor), sizeof(factor));
+	// Tables written before the header was padded start with ALT1
+	const bool padded = std::memcmp(magic, "ALT2", 4) == 0;
+	if(padded) {
+		char padding[4];
+		in.read(padding, sizeof(padding));
+	}
+	if(!in || (!padded && std::memcmp(magic, "ALT1", 4) != 0) || width != sizeof(Distance)) {
+		return false;
+	}
+	std::vector<Index> ids(count);
+	for(auto landmark = ids.begin(); landmark != ids.end(); ++landmark) {
+		std::uint64_t id {0};
+		in.read(reinterpret_cast<char*>(&id), sizeof(id));
+		*landmark = Index(id);
+	}
+	std::vector<Distance> rows(std::size_t(size) * count);
+	in.read(reinterpret_cast<char*>(rows.data()), std::streamsize(rows.size() * sizeof(Distance)));
+	if(!in) {
+		return false;
+	}
+	landmarks.swap(ids);
+	table.swap(rows);
+	entries = table.data();
+	nodes = std::size_t(size);
+	scale = factor;
+	return true;
+}
+
+template <typename graph_type, typename distance_type>
+const bool Landmarks<graph_type, distance_type>::view(const void *data, std::size_t size) {
+	const char *bytes = static_cast<const char*>(data);
+	std::uint32_t width {0};
+	std::uint32_t count {0};
+	std::uint64_t length {0};
+	if(size < 28 || (std::memcmp(bytes, "ALT2", 4) != 0 && std::memcmp(bytes, "ALT1", 4) != 0)) {
+		return false;
+	}
+	const std::size_t header = bytes[3] == '2' ? 32 : 28;
+	std::memcpy(&width, bytes + 4, sizeof(width));
+	std::memcpy(&count, bytes + 8, sizeof(count));
+	std::memcpy(&length, bytes + 12, sizeof(length));
+	const std::size_t offset = header + std::size_t(count) * sizeof(std::uint64_t);
+	if(width != sizeof(Distance) || size < offset + std::size_t(length) * count * sizeof(Distance) ||
+	   reinterpret_cast<std::uintptr_t>(bytes + offset) % alignof(Distance) != 0) {
+		return false;
+	}
+	std::memcpy(&scale, bytes + 20, sizeof(scale));
+	landmarks.resize(count);
+	for(std::uint32_t index = 0; index < count; ++index) {
+		std::uint64_t id {0};
+		std::memcpy(&id, bytes + header + index * sizeof(id), sizeof(id));
+		landmarks[index] = Index(id);
+	}
+	std::vector<Distance>().swap(table);
+	entries = reinterpret_cast<const Distance*>(bytes + offset);
+	nodes = std::size_t(length);
+	return true;
+}
+
+/**
+ * View of a graph using the larger of its own heuristic and the landmark bound, the graph_type of
+ * a search guided by landmarks. Node types of AStar can use Landmarks::heuristic in their heuristic instead.
+ */
+template <typename graph_type, typename distance_type = float>
+class LandmarkGraph {
+public:
+	typedef typename graph_type::Index Index;
+	typedef typename graph_type::Cost  Cost;
+	
+private:
+	const graph_type *graph;
+	const Landmarks<graph_type, distance_type> *landmarks;
+	
+public:
+	LandmarkGraph(const graph_type &graph, const Landmarks<graph_type, distance_type> &landmarks):
+	graph(&graph), landmarks(&landmarks) {}
+	
+	const graph_type &base() const {
+		return *graph;
+	}
+	const Index size() const {
+		return graph->size();
+	}
+	/**
+	 * The version of the graph, present if the graph has one, see Grid::version.
+	 */
+	template <typename base_type = graph_type>
+	auto version() const -> decltype(std::declval<const base_type&>().version()) {
+		return graph->version();
+	}
+	const Cost heuristic(Index id, Index goal) const {
+		return std::max(graph->heuristic(id, goal), landmarks->heuristic(id, goal));
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		graph->for_each_successor(id, visit);
+	}
+};
+
+#endif
@@ -0,0 +1,237 @@
+//
+// Memory-mapped files of grids and precomputed search data
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_MAPFILE_001_HPP
+#define SCU_MAPFILE_001_HPP
+
+#include "GridAStar.hpp"
+#include "Landmarks.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * File of a grid and its precomputed tables, read through a read-only shared memory mapping.
+ *
+ * Layout, in native byte order:
+ *   0:  magic "SCUMAP\0\0"
+ *   8:  std::uint32_t version, currently 1
+ *   12: std::uint32_t number of sections
+ *   16: section table, per section std::uint32_t kind, std::uint32_t index, std::uint64_t offset, std::uint64_t size
+ * Every section starts at an offset aligned to 64 bytes and holds the data written by the save member of its
+ * type. Readers skip sections of unknown kinds, so later versions may add kinds without breaking older readers.
+ *
+ * Grid and Landmarks attached to a MapFile are views of the mapped pages: nothing is copied or recomputed,
+ * so opening takes as long as mapping the file, and processes mapping the same file share its pages.
+ * The views are valid as long as the MapFile is open.
+ */
+class MapFile {
+public:
+	enum Kind: std::uint32_t {
+		GridSection = 1,
+		LandmarkSection = 2
+	};
+	
+	static const std::uint32_t version = 1;
+	static const std::size_t alignment = 64;
+	
+private:
+	struct Entry {
+		std::uint32_t kind;
+		std::uint32_t index;
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+	
+	const char *data {nullptr};
+	std::size_t length {0};
+	std::uint32_t count {0};
+	
+public:
+	MapFile() {}
+	explicit MapFile(const std::string &path) {
+		open(path);
+	}
+	MapFile(const MapFile &) = delete;
+	MapFile &operator=(const MapFile &) = delete;
+	~MapFile() {
+		close();
+	}
+	
+	/**
+	 * Maps the file at @path, replacing any previously mapped file. Returns false if it can not be mapped
+	 * or is no valid map file of a supported version.
+	 */
+	const bool open(const std::string &path);
+	void close();
+	
+	const bool valid() const {
+		return data != nullptr;
+	}
+	/**
+	 * Returns the @index-th section of @kind and stores its size in @size, or nullptr if there is none.
+	 */
+	const void *section(std::uint32_t kind, std::uint32_t index, std::size_t &size) const;
+	
+	/**
+	 * Attaches @grid to the grid of the file. Returns false if the file holds no grid.
+	 */
+	const bool attach(Grid &grid) const {
+		std::size_t size {0};
+		const void *bytes = section(GridSection, 0, size);
+		return bytes && grid.view(bytes, size);
+	}
+	/**
+	 * Attaches @landmarks to the @index-th landmark tables of the file. Returns false if there are none
+	 * or they were saved with another distance_type.
+	 */
+	template <typename graph_type, typename distance_type>
+	const bool attach(Landmarks<graph_type, distance_type> &landmarks, std::uint32_t index = 0) const {
+		std::size_t size {0};
+		const void *bytes = section(LandmarkSection, index, size);
+		return bytes && landmarks.view(bytes, size);
+	}
+};
+
+/**
+ * Collects the sections of a MapFile and writes them.
+ */
+class MapFileWriter {
+private:
+	struct Section {
+		std::uint32_t kind;
+		std::uint32_t index;
+		std::string payload;
+	};
+	std::vector<Section> sections {};
+	
+public:
+	void add(std::uint32_t kind, std::uint32_t index, const std::string &payload) {
+		sections.push_back({kind, index, payload});
+	}
+	void add(const Grid &grid) {
+		std::ostringstream out;
+		grid.save(out);
+		add(MapFile::GridSection, 0, out.str());
+	}
+	template <typename graph_type, typename distance_type>
+	void add(const Landmarks<graph_type, distance_type> &landmarks, std::uint32_t index = 0) {
+		std::ostringstream out;
+		landmarks.save(out);
+		add(MapFile::LandmarkSection, index, out.str());
+	}
+	
+	/**
+	 * Writes the file to @path. Returns false on failure.
+	 */
+	const bool write(const std::string &path) const;
+};
+
+inline const bool MapFile::open(const std::string &path) {
+	close();
+	const int descriptor = ::open(path.c_str(), O_RDONLY);
+	if(descriptor < 0) {
+		return false;
+	}
+	struct stat status;
+	if(fstat(descriptor, &status) != 0 || status.st_size < 16) {
+		::close(descriptor);
+		return false;
+	}
+	const std::size_t size = std::size_t(status.st_size);
+	void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+	::close(descriptor);
+	if(mapping == MAP_FAILED) {
+		return false;
+	}
+	
+	const char *bytes = static_cast<const char*>(mapping);
+	std::uint32_t header[2];
+	std::memcpy(header, bytes + 8, sizeof(header));
+	bool valid = std::memcmp(bytes, "SCUMAP\0\0", 8) == 0 && header[0] == version &&
+	             16 + std::uint64_t(header[1]) * sizeof(Entry) <= size;
+	for(std::uint32_t index = 0; valid && index < header[1]; ++index) {
+		Entry entry;
+		std::memcpy(&entry, bytes + 16 + index * sizeof(Entry), sizeof(Entry));
+		valid = entry.offset % alignment == 0 && entry.offset <= size && entry.size <= size - entry.offset;
+	}
+	if(!valid) {
+		munmap(mapping, size);
+		return false;
+	}
+	data = bytes;
+	length = size;
+	count = header[1];
+	return true;
+}
+
+inline void MapFile::close() {
+	if(data) {
+		munmap(const_cast<char*>(data), length);
+	}
+	data = nullptr;
+	length = 0;
+	count = 0;
+}
+
+inline const void *MapFile::section(std::uint32_t kind, std::uint32_t index, std::size_t &size) const {
+	for(std::uint32_t position = 0; position < count; ++position) {
+		Entry entry;
+		std::memcpy(&entry, data + 16 + position * sizeof(Entry), sizeof(Entry));
+		if(entry.kind == kind && entry.index == index) {
+			size = std::size_t(entry.size);
+			return data + entry.offset;
+		}
+	}
+	size = 0;
+	return nullptr;
+}
+
+inline const bool MapFileWriter::write(const std::string &path) const {
+	std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+	const std::uint32_t header[2] {MapFile::version, std::uint32_t(sections.size())};
+	out.write("SCUMAP\0\0", 8);
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+	
+	std::uint64_t offset = 16 + sections.size() * (2 * sizeof(std::uint32_t) + 2 * sizeof(std::uint64_t));
+	for(auto section = sections.begin(); section != sections.end(); ++section) {
+		offset = (offset + MapFile::alignment - 1) / MapFile::alignment * MapFile::alignment;
+		const std::uint32_t ids[2] {section->kind, section->index};
+		const std::uint64_t extent[2] {offset, section->payload.size()};
+		out.write(reinterpret_cast<const char*>(ids), sizeof(ids));
+		out.write(reinterpret_cast<const char*>(extent), sizeof(extent));
+		offset += section->payload.size();
+	}
+	for(auto section = sections.begin(); section != sections.end(); ++section) {
+		const std::uint64_t position = std::uint64_t(out.tellp());
+		const std::uint64_t padding = (MapFile::alignment - position % MapFile::alignment) % MapFile::alignment;
+		out.write(std::string(padding, '\0').data(), std::streamsize(padding));
+		out.write(section->payload.data(), std::streamsize(section->payload.size()));
+	}
+	return bool(out);
+}
+
+#endif
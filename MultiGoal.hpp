@@ -0,0 +1,292 @@
+//
+// Searches towards the nearest of many goals, and flow fields of the distances to a set of sources
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_MULTIGOAL_001_HPP
+#define SCU_MULTIGOAL_001_HPP
+
+#include "AStar.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+/**
+ * View of a graph with one additional node, the sink, that every goal of a set leads to at no cost.
+ * A search towards the sink ends at the first goal it settles, which is the nearest one. The heuristic
+ * is the smallest heuristic to any goal, so it stays admissible and consistent when the heuristic of
+ * the graph is, and its cost grows with the number of goals.
+ *
+ * Models the graph_type of AStarSearch.
+ */
+template <typename graph_type>
+class GoalSetGraph {
+public:
+	typedef typename graph_type::Index Index;
+	typedef typename graph_type::Cost  Cost;
+	
+private:
+	const graph_type *graph;
+	std::vector<Index> goals {};
+	std::vector<unsigned int> marks;
+	unsigned int mark {0};
+	
+public:
+	explicit GoalSetGraph(const graph_type &graph): graph(&graph), marks(graph.size(), 0) {}
+	
+	/**
+	 * Replaces the goals by the nodes from @goals_begin to @goals_end. Duplicates are ignored.
+	 */
+	template <typename iterator_type>
+	void assign(iterator_type goals_begin, iterator_type goals_end) {
+		if(++mark == 0) {
+			std::fill(marks.begin(), marks.end(), 0);
+			mark = 1;
+		}
+		goals.clear();
+		for(auto goal = goals_begin; goal != goals_end; ++goal) {
+			if(*goal < marks.size() && marks[*goal] != mark) {
+				marks[*goal] = mark;
+				goals.push_back(*goal);
+			}
+		}
+	}
+	const bool goal(Index id) const {
+		return id < marks.size() && marks[id] == mark;
+	}
+	const Index sink() const {
+		return graph->size();
+	}
+	
+	const Index size() const {
+		return graph->size() + 1;
+	}
+	const Cost heuristic(Index id, Index) const {
+		if(id == sink() || goals.empty()) {
+			return Cost(0);
+		}
+		Cost lowest = graph->heuristic(id, goals.front());
+		for(auto goal = goals.begin() + 1; goal != goals.end(); ++goal) {
+			lowest = std::min(lowest, graph->heuristic(id, *goal));
+		}
+		return lowest;
+	}
+	template <typename visitor_type>
+	void for_each_successor(Index id, visitor_type &&visit) const {
+		if(id == sink()) {
+			return;
+		}
+		graph->for_each_successor(id, visit);
+		if(goal(id)) {
+			visit(sink(), Cost(0));
+		}
+	}
+};
+
+/**
+ * Holds the GoalSetGraph of a MultiGoalAStar, constructed before the search viewing it.
+ */
+template <typename graph_type>
+struct GoalSetHolder {
+	explicit GoalSetHolder(const graph_type &graph): goalSet(graph) {}
+	GoalSetGraph<graph_type> goalSet;
+};
+
+/**
+ * Search from one start to the nearest of many goals, stopping at the first goal reached. One query
+ * replaces a search per goal. The path ends at the goal reached, see goal(); the sink of the GoalSetGraph
+ * is not part of it.
+ *
+ * For many starts and one goal on an undirected graph, search from the goal with the starts as goals,
+ * or compute a FlowField once and let every agent follow it.
+ *
+ * Template parameters:
+ *   graph_type:      See AStarSearch, without successor pruning
+ *   open_list_type:  Open list implementation, BinaryHeapOpenList, MultisetOpenList or, for integral costs, BucketOpenList
+ *   statistics_type: Statistics policy, NoStatistics or SearchStatistics
+ */
+template <typename graph_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList,
+          typename statistics_type = NoStatistics>
+class MultiGoalAStar: private GoalSetHolder<graph_type>, public AStarSearch<GoalSetGraph<graph_type>, open_list_type, statistics_type> {
+public:
+	typedef AStarSearch<GoalSetGraph<graph_type>, open_list_type, statistics_type> Search;
+	typedef typename Search::Index  Index;
+	typedef typename Search::Cost   Cost;
+	typedef typename Search::Status Status;
+	
+private:
+	void strip();
+	
+public:
+	explicit MultiGoalAStar(const graph_type &graph): GoalSetHolder<graph_type>(graph), Search(this->goalSet) {}
+	
+	/**
+	 * Searches the path from @path_begin to the nearest of the nodes from @goals_begin to @goals_end.
+	 * Returns if a goal was reached.
+	 */
+	template <typename iterator_type>
+	const bool query(Index path_begin, iterator_type goals_begin, iterator_type goals_end) {
+		this->goalSet.assign(goals_begin, goals_end);
+		// The target is always the sink, the cached heuristics belong to the previous goals
+		this->forget();
+		Search::query(path_begin, this->goalSet.sink());
+		strip();
+		return this->found;
+	}
+	const bool query(Index path_begin, const std::vector<Index> &goals) {
+		return query(path_begin, goals.begin(), goals.end());
+	}
+	/**
+	 * Begins a query to the nearest of the nodes from @goals_begin to @goals_end, carried out by step.
+	 */
+	template <typename iterator_type>
+	void start(Index path_begin, iterator_type goals_begin, iterator_type goals_end) {
+		this->goalSet.assign(goals_begin, goals_end);
+		// The target is always the sink, the cached heuristics belong to the previous goals
+		this->forget();
+		Search::start(path_begin, this->goalSet.sink());
+	}
+	const Status step(std::size_t max_expansions = std::numeric_limits<std::size_t>::max()) {
+		const Status status = Search::step(max_expansions);
+		strip();
+		return status;
+	}
+	
+	/**
+	 * The goal reached by the last query, none if no goal was reached.
+	 */
+	const Index goal() const {
+		return this->found && !this->result.empty() ? this->result.back() : Search::none;
+	}
+};
+
+/**
+ * Removes the sink from the end of the resulting path.
+ */
+template<typename graph_type, template <typename, typename> class open_list_type, typename statistics_type>
+void MultiGoalAStar<graph_type, open_list_type, statistics_type>::strip() {
+	if(!this->result.empty() && this->result.back() == this->goalSet.sink()) {
+		this->result.pop_back();
+	}
+}
+
+/**
+ * Distance and direction fields towards a set of sources, computed by one Dijkstra sweep over the graph.
+ *
+ * For every node, compute writes the distance to the nearest source and the next node on a shortest path
+ * towards it. Every agent heading for the sources follows the directions from wherever it stands, so a
+ * crowd shares one computation instead of searching a path per agent. The sweep follows the edges backward,
+ * as DirectedGraph does, so the distances are those towards the sources on directed graphs as well.
+ *
+ * The search data is kept between computations, so repeated fields do not allocate.
+ *
+ * Template parameters:
+ *   graph_type:     See AStarSearch. Directed graphs provide for_each_predecessor, see DirectedGraph.
+ *   open_list_type: Open list implementation, BinaryHeapOpenList, MultisetOpenList or, for integral costs, BucketOpenList
+ */
+template <typename graph_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList>
+class FlowField {
+public:
+	typedef typename graph_type::Index Index;
+	typedef typename graph_type::Cost  Cost;
+	
+	static const Index none;
+	
+private:
+	/**
+	 * The reverse graph without heuristic and one additional node, the origin, leading to every source at no cost.
+	 */
+	struct Sweep {
+		typedef typename graph_type::Index Index;
+		typedef typename graph_type::Cost  Cost;
+		DirectedGraph<graph_type> reverse;
+		std::vector<Index> sources;
+		
+		const Index origin() const {
+			return reverse.size();
+		}
+		const Index size() const {
+			return reverse.size() + 1;
+		}
+		const Cost heuristic(Index, Index) const {
+			return Cost(0);
+		}
+		template <typename visitor_type>
+		void for_each_successor(Index id, visitor_type &&visit) const {
+			if(id == origin()) {
+				for(auto source = sources.begin(); source != sources.end(); ++source) {
+					visit(*source, Cost(0));
+				}
+			}
+			else {
+				reverse.for_each_successor(id, visit);
+			}
+		}
+	};
+	
+	Sweep sweep;
+	AStarSearch<Sweep, open_list_type> search;
+	
+public:
+	explicit FlowField(const graph_type &graph): sweep {DirectedGraph<graph_type>(graph, true), {}}, search(sweep) {}
+	FlowField(const FlowField &) = delete;
+	FlowField &operator=(const FlowField &) = delete;
+	
+	/**
+	 * Computes the field towards the nodes from @sources_begin to @sources_end. @distances and @directions
+	 * receive one entry per node: the distance to the nearest source, the maximum of Cost if none is reachable,
+	 * and the next node towards it, none for the sources themselves and for nodes that reach no source.
+	 * Either buffer may be null. Returns the number of nodes reaching a source.
+	 */
+	template <typename iterator_type>
+	const std::size_t compute(iterator_type sources_begin, iterator_type sources_end, Cost *distances, Index *directions);
+	const std::size_t compute(const std::vector<Index> &sources, Cost *distances, Index *directions) {
+		return compute(sources.begin(), sources.end(), distances, directions);
+	}
+	/**
+	 * Computes the field towards @source.
+	 */
+	const std::size_t compute(Index source, Cost *distances, Index *directions) {
+		return compute(&source, &source + 1, distances, directions);
+	}
+};
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+const typename FlowField<graph_type, open_list_type>::Index FlowField<graph_type, open_list_type>::none = std::numeric_limits<Index>::max();
+
+template<typename graph_type, template <typename, typename> class open_list_type>
+template <typename iterator_type>
+const std::size_t FlowField<graph_type, open_list_type>::compute(iterator_type sources_begin, iterator_type sources_end, Cost *distances, Index *directions) {
+	sweep.sources.assign(sources_begin, sources_end);
+	// No node is the target, so the search settles every node reachable from the origin
+	search.query(sweep.origin(), sweep.size());
+	std::size_t reached {0};
+	for(Index id = 0; id < sweep.origin(); ++id) {
+		const bool settled = search.visited(id) && search.state(id).closed;
+		const Index next = settled ? search.state(id).prev : none;
+		reached += settled;
+		if(distances) {
+			distances[id] = settled ? search.state(id).g : std::numeric_limits<Cost>::max();
+		}
+		if(directions) {
+			directions[id] = next == sweep.origin() ? none : next;
+		}
+	}
+	return reached;
+}
+
+#endif
@@ -0,0 +1,468 @@
+//
+// Hash distributed A* search of a single query on several threads
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_PARALLELASTAR_001_HPP
+#define SCU_PARALLELASTAR_001_HPP
+
+#include "AStar.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Hash distributed A* (HDA*): one query searched by a pool of worker threads.
+ *
+ * Every node is owned by one worker, chosen by a hash of its id, and only its owner reads or writes its
+ * search data and holds it in its open list. A worker expanding a node relaxes the successors it owns
+ * directly and sends the others to their owners. Messages are collected per destination and handed over
+ * in batches through lock-free queues with many producers and one consumer, and the batches return to
+ * their sender for reuse, so a query does not allocate once the batches exist.
+ *
+ * The owner of the target publishes the cost of the best path found so far, and workers skip nodes whose
+ * priority reaches it. The search ends when no worker has a node below that cost and no message is in
+ * flight. Workers re-expand nodes reached again at a lower cost, so with an admissible heuristic the
+ * weight matches the one of a serial AStarSearch, while the path may be another one of the same weight.
+ *
+ * Consecutive ids are owned in runs of 16, so neighbouring cells of a grid row share an owner and the
+ * search data of different workers rarely shares a cache line. The calling thread works as one of the workers.
+ *
+ * Template parameters:
+ *   graph_type:     See AStarSearch, without successor pruning
+ *   open_list_type: Open list implementation, BinaryHeapOpenList, MultisetOpenList or, for integral costs, BucketOpenList
+ */
+template <typename graph_type,
+          template <typename, typename> class open_list_type = BinaryHeapOpenList>
+class ParallelAStar {
+public:
+	typedef graph_type            Graph;
+	typedef typename Graph::Index Index;
+	typedef typename Graph::Cost  Cost;
+	typedef typename std::vector<Index>::const_iterator PathIterator;
+	
+	static const Index none;
+	
+	/**
+	 * Search data of a single node, written only by the worker owning it.
+	 */
+	struct State {
+		Cost  g {0};
+		Cost  h {0};
+		Index prev {none};
+		Index slot {0};
+		unsigned int generation {0};
+	};
+	
+private:
+	struct StateAccess {
+		StateAccess(std::vector<State> *states = nullptr): states(states) {}
+		std::vector<State> *states;
+		const bool less(const Index lhs, const Index rhs) const {
+			return priority(lhs) < priority(rhs);
+		}
+		const Cost priority(const Index id) const {
+			const State &state = (*states)[id];
+			return state.g + state.h;
+		}
+		Index &slot(const Index id) const {
+			return (*states)[id].slot;
+		}};
+	typedef open_list_type<Index, StateAccess> OpenList;
+	
+	/**
+	 * A successor reached at cost @g through @prev, sent to the owner of @id.
+	 */
+	struct Message {
+		Index id;
+		Index prev;
+		Cost  g;
+	};
+	struct Batch {
+		Batch *next {nullptr};
+		unsigned int sender {0};
+		std::vector<Message> messages {};
+	};
+	/**
+	 * Lock-free stack of batches, pushed by any thread and emptied at once by its owner. Taking all
+	 * batches with one exchange keeps it free of the ABA problem.
+	 */
+	struct Stack {
+		std::atomic<Batch*> head {nullptr};
+		void push(Batch *batch) {
+			Batch *top = head.load();
+			do {
+				batch->next = top;
+			} while(!head.compare_exchange_weak(top, batch));
+		}
+		Batch *take() {
+			return head.exchange(nullptr);
+		}
+	};
+	struct Worker {
+		explicit Worker(std::vector<State> *states): openList(StateAccess(states)) {}
+		OpenList openList;
+		Stack inbox {};
+		Stack returned {};
+		std::vector<Batch*> outboxes {};
+		Batch *spare {nullptr};
+		std::vector<std::unique_ptr<Batch>> batches {};
+		std::size_t expansions {0};
+		bool idle {false};
+	};
+	
+	/**
+	 * Messages per batch before it is handed over, and expansions between handing over all batches.
+	 */
+	static const std::size_t batchSize = 64;
+	static const std::size_t slice = 64;
+	
+	const Graph *graph;
+	std::vector<State> states;
+	std::vector<std::unique_ptr<Worker>> workers {};
+	std::vector<std::thread> threads {};
+	
+	Index path_begin {0};
+	Index path_end {0};
+	unsigned int generation {0};
+	std::atomic<Cost> best {std::numeric_limits<Cost>::max()};
+	std::atomic<std::size_t> active {0};
+	std::vector<Index> result {};
+	
+	std::mutex mutex {};
+	std::condition_variable wake {};
+	std::condition_variable done {};
+	unsigned int epoch {0};
+	unsigned int pending {0};
+	bool stopping {false};
+	
+	const unsigned int owner(Index id) const {
+		return unsigned(((std::uint64_t(id) >> 4) * 0x9e3779b97f4a7c15ull) >> 32) % unsigned(workers.size());
+	}
+	State &touch(Index id);
+	void improve(unsigned int self, Index id, Index prev, Cost g);
+	void send(unsigned int self, unsigned int target, const Message &message);
+	void flush(unsigned int self);
+	const bool receive(unsigned int self);
+	void expand(unsigned int self, Index id);
+	void work(unsigned int self);
+	void loop(unsigned int self);
+	
+public:
+	/**
+	 * Creates a pool of @workers threads searching @graph, including the calling thread.
+	 */
+	explicit ParallelAStar(const Graph &graph, unsigned int workers = std::thread::hardware_concurrency());
+	ParallelAStar(const ParallelAStar &) = delete;
+	ParallelAStar &operator=(const ParallelAStar &) = delete;
+	~ParallelAStar();
+	
+	const unsigned int size() const {
+		return static_cast<unsigned int>(workers.size());
+	}
+	
+	/**
+	 * Searches the path from @path_begin to @path_end on all workers, blocking until it is found or
+	 * ruled out. Returns if the target was reached.
+	 */
+	const bool query(Index path_begin, Index path_end);
+	
+	const bool successful() const {
+		return !result.empty();
+	}
+	const Cost weight() const {
+		return successful() ? best.load() : Cost(0);
+	}
+	const unsigned int steps() const {
+		return result.empty() ? 0 : static_cast<unsigned int>(result.size() - 1);
+	}
+	/**
+	 * The number of nodes expanded by all workers in the last query, counting re-expansions.
+	 */
+	const std::size_t expansions() const;
+	
+	const PathIterator begin() const {
+		return result.begin();
+	}
+	const PathIterator end() const {
+		return result.end();
+	}
+};
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+const typename ParallelAStar<graph_type, open_list_type>::Index ParallelAStar<graph_type, open_list_type>::none = std::numeric_limits<Index>::max();
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+ParallelAStar<graph_type, open_list_type>::ParallelAStar(const Graph &graph, unsigned int workers):
+graph(&graph), states(graph.size()) {
+	if(workers == 0) {
+		workers = 1;
+	}
+	for(unsigned int self = 0; self < workers; ++self) {
+		this->workers.emplace_back(new Worker(&states));
+		this->workers.back()->outboxes.resize(workers, nullptr);
+	}
+	for(unsigned int self = 1; self < workers; ++self) {
+		threads.emplace_back(&ParallelAStar::loop, this, self);
+	}
+}
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+ParallelAStar<graph_type, open_list_type>::~ParallelAStar() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for(auto thread = threads.begin(); thread != threads.end(); ++thread) {
+		thread->join();
+	}
+}
+
+/**
+ * Returns the search data of @id, initialised on the first access of the query.
+ */
+template <typename graph_type, template <typename, typename> class open_list_type>
+typename ParallelAStar<graph_type, open_list_type>::State &ParallelAStar<graph_type, open_list_type>::touch(Index id) {
+	State &state = states[id];
+	if(state.generation != generation) {
+		state.generation = generation;
+		state.g = std::numeric_limits<Cost>::max();
+		state.h = graph->heuristic(id, path_end);
+		state.prev = none;
+		state.slot = 0;
+	}
+	return state;
+}
+
+/**
+ * Records that the owned node @id is reached at cost @g through @prev, and queues it if that is cheaper.
+ */
+template <typename graph_type, template <typename, typename> class open_list_type>
+void ParallelAStar<graph_type, open_list_type>::improve(unsigned int self, Index id, Index prev, Cost g) {
+	State &state = touch(id);
+	if(g >= state.g) {
+		return;
+	}
+	state.g = g;
+	state.prev = prev;
+	if(id == path_end) {
+		best.store(g);
+		return;
+	}
+	OpenList &openList = workers[self]->openList;
+	if(openList.contains(id)) {
+		openList.update(id);
+	}
+	else if(g + state.h < best.load()) {
+		openList.push(id);
+	}
+}
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+void ParallelAStar<graph_type, open_list_type>::send(unsigned int self, unsigned int target, const Message &message) {
+	Worker &worker = *workers[self];
+	Batch *&out = worker.outboxes[target];
+	if(!out) {
+		if(!worker.spare) {
+			worker.spare = worker.returned.take();
+		}
+		if(!worker.spare) {
+			worker.batches.emplace_back(new Batch());
+			worker.spare = worker.batches.back().get();
+			worker.spare->sender = self;
+		}
+		out = worker.spare;
+		worker.spare = out->next;
+	}
+	out->messages.push_back(message);
+	if(out->messages.size() >= batchSize) {
+		active.fetch_add(out->messages.size());
+		workers[target]->inbox.push(out);
+		out = nullptr;
+	}
+}
+
+/**
+ * Hands over all pending batches of @self. Messages in flight count as activity, so the
+ * search cannot end before their receivers took them.
+ */
+template <typename graph_type, template <typename, typename> class open_list_type>
+void ParallelAStar<graph_type, open_list_type>::flush(unsigned int self) {
+	Worker &worker = *workers[self];
+	for(unsigned int target = 0; target < worker.outboxes.size(); ++target) {
+		Batch *&out = worker.outboxes[target];
+		if(out) {
+			active.fetch_add(out->messages.size());
+			workers[target]->inbox.push(out);
+			out = nullptr;
+		}
+	}
+}
+
+/**
+ * Takes all batches sent to @self and returns them to their senders. Returns if there were any.
+ */
+template <typename graph_type, template <typename, typename> class open_list_type>
+const bool ParallelAStar<graph_type, open_list_type>::receive(unsigned int self) {
+	Worker &worker = *workers[self];
+	Batch *batch = worker.inbox.take();
+	if(!batch) {
+		return false;
+	}
+	if(worker.idle) {
+		// Become active before the messages stop counting, so the activity never drops to zero in between
+		active.fetch_add(1);
+		worker.idle = false;
+	}
+	while(batch) {
+		Batch *next = batch->next;
+		for(auto message = batch->messages.begin(); message != batch->messages.end(); ++message) {
+			improve(self, message->id, message->prev, message->g);
+		}
+		active.fetch_sub(batch->messages.size());
+		batch->messages.clear();
+		workers[batch->sender]->returned.push(batch);
+		batch = next;
+	}
+	return true;
+}
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+void ParallelAStar<graph_type, open_list_type>::expand(unsigned int self, Index id) {
+	++workers[self]->expansions;
+	const Cost base = states[id].g;
+	graph->for_each_successor(id, [this, self, id, base](const Index successor, const Cost cost) {
+		const Cost g = base + cost;
+		if(g >= best.load(std::memory_order_relaxed)) {
+			return;
+		}
+		const unsigned int target = owner(successor);
+		if(target == self) {
+			improve(self, successor, id, g);
+		}
+		else {
+			send(self, target, Message {successor, id, g});
+		}
+	});
+}
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+void ParallelAStar<graph_type, open_list_type>::work(unsigned int self) {
+	Worker &worker = *workers[self];
+	OpenList &openList = worker.openList;
+	StateAccess access(&states);
+	for(;;) {
+		receive(self);
+		std::size_t count {0};
+		while(count < slice && !openList.empty() && access.priority(openList.top()) < best.load()) {
+			expand(self, openList.pop());
+			++count;
+		}
+		flush(self);
+		if(count) {
+			continue;
+		}
+		if(!worker.idle) {
+			worker.idle = true;
+			active.fetch_sub(1);
+		}
+		// Idle workers send nothing, so once neither work nor messages are left none can appear
+		if(active.load() == 0) {
+			break;
+		}
+		std::this_thread::yield();
+	}
+	openList.clear();
+}
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+void ParallelAStar<graph_type, open_list_type>::loop(unsigned int self) {
+	unsigned int seen {0};
+	for(;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, seen] { return stopping || epoch != seen; });
+			if(stopping) {
+				return;
+			}
+			seen = epoch;
+		}
+		work(self);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(--pending == 0) {
+				done.notify_all();
+			}
+		}
+	}
+}
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+const bool ParallelAStar<graph_type, open_list_type>::query(Index path_begin, Index path_end) {
+	this->path_begin = path_begin;
+	this->path_end = path_end;
+	result.clear();
+	if(++generation == 0) {
+		for(auto state = states.begin(); state != states.end(); ++state) {
+			state->generation = 0;
+		}
+		generation = 1;
+	}
+	best.store(std::numeric_limits<Cost>::max());
+	active.store(workers.size());
+	for(auto worker = workers.begin(); worker != workers.end(); ++worker) {
+		(*worker)->expansions = 0;
+		(*worker)->idle = false;
+	}
+	improve(owner(path_begin), path_begin, none, Cost(0));
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending = static_cast<unsigned int>(threads.size());
+		++epoch;
+	}
+	wake.notify_all();
+	work(0);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return pending == 0; });
+	}
+	
+	if(best.load() == std::numeric_limits<Cost>::max()) {
+		return false;
+	}
+	for(Index id = path_end; id != none; id = states[id].prev) {
+		result.push_back(id);
+	}
+	std::reverse(result.begin(), result.end());
+	return true;
+}
+
+template <typename graph_type, template <typename, typename> class open_list_type>
+const std::size_t ParallelAStar<graph_type, open_list_type>::expansions() const {
+	std::size_t count {0};
+	for(auto worker = workers.begin(); worker != workers.end(); ++worker) {
+		count += (*worker)->expansions;
+	}
+	return count;
+}
+
+#endif
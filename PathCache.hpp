@@ -0,0 +1,325 @@
+//
+// Least recently used cache of search results, shared between searches
+//
+// Copyright (c) 2013 Christian Sdunek.
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef SCU_PATHCACHE_001_HPP
+#define SCU_PATHCACHE_001_HPP
+
+#include "AStar.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Least recently used cache of found paths, keyed by start, goal and the version of the graph.
+ *
+ * Every node of a cached path is indexed together with the goal of the path, so a query hits the cache
+ * when its start lies anywhere on a cached path to its goal: the answer is the suffix of that path,
+ * which is a shortest path itself when the cached one is. Paths stored for an older version of the graph
+ * are never returned and are dropped when a lookup finds them. The storage of evicted paths is reused.
+ *
+ * The cache is split into shards by goal, each guarded by its own mutex, so concurrent lookups, such as
+ * those of the workers of a BatchAStar, rarely contend. All paths to one goal live in the same shard.
+ *
+ * Template parameters:
+ *   index_type: Node id type of the graph
+ *   cost_type:  Edge cost type of the graph
+ */
+template <typename index_type, typename cost_type>
+class PathCache {
+public:
+	typedef index_type Index;
+	typedef cost_type  Cost;
+	
+private:
+	/**
+	 * A cached path together with the cost from each of its nodes to its end.
+	 */
+	struct Entry {
+		std::uint64_t version {0};
+		std::vector<Index> path {};
+		std::vector<Cost> remaining {};
+	};
+	typedef typename std::list<Entry>::iterator Link;
+	
+	struct Key {
+		Index node;
+		Index goal;
+		const bool operator==(const Key &rhs) const {
+			return node == rhs.node && goal == rhs.goal;
+		}
+	};
+	struct KeyHash {
+		std::size_t operator()(const Key &key) const {
+			return std::size_t(mix(std::uint64_t(key.node)) ^ std::uint64_t(key.goal));
+		}
+	};
+	struct Position {
+		Link entry;
+		std::size_t offset;
+	};
+	struct Shard {
+		std::mutex mutex {};
+		std::list<Entry> entries {};
+		std::list<Entry> spare {};
+		std::unordered_map<Key, Position, KeyHash> index {};
+	};
+	
+	std::vector<std::unique_ptr<Shard>> shards {};
+	std::size_t capacity;
+	
+	static std::uint64_t mix(std::uint64_t value) {
+		return value * 0x9e3779b97f4a7c15ull;
+	}
+	Shard &shard(Index goal) const {
+		return *shards[(mix(std::uint64_t(goal)) >> 32) % shards.size()];
+	}
+	static void drop(Shard &shard, Link entry);
+	
+public:
+	/**
+	 * Creates a cache of up to @capacity paths, split into @shards shards.
+	 */
+	explicit PathCache(std::size_t capacity = 4096, unsigned int shards = 16);
+	PathCache(const PathCache &) = delete;
+	PathCache &operator=(const PathCache &) = delete;
+	
+	/**
+	 * Looks up a path from @path_begin to @path_end on @version of the graph. On a hit, writes the path
+	 * to @path, its weight to @weight and returns true.
+	 */
+	const bool lookup(Index path_begin, Index path_end, std::uint64_t version, std::vector<Index> &path, Cost &weight);
+	/**
+	 * Stores the @length nodes of @path, found on @version of the graph, with the cost @remaining from each
+	 * of them to the end of the path. Evicts the least recently used path of the shard when it is full.
+	 */
+	void insert(std::uint64_t version, const Index *path, const Cost *remaining, std::size_t length);
+	/**
+	 * Removes all paths.
+	 */
+	void clear();
+	/**
+	 * The number of cached paths.
+	 */
+	const std::size_t size() const;
+};
+
+template <typename index_type, typename cost_type>
+PathCache<index_type, cost_type>::PathCache(std::size_t capacity, unsigned int shards):
+capacity(std::max<std::size_t>(1, capacity / std::max(1u, shards))) {
+	for(unsigned int count = 0; count < std::max(1u, shards); ++count) {
+		this->shards.emplace_back(new Shard());
+	}
+}
+
+/**
+ * Unindexes @entry and moves it to the spare entries of @shard, keeping its storage.
+ */
+template <typename index_type, typename cost_type>
+void PathCache<index_type, cost_type>::drop(Shard &shard, Link entry) {
+	const Index goal = entry->path.back();
+	for(auto node = entry->path.begin(); node != entry->path.end(); ++node) {
+		auto position = shard.index.find(Key {*node, goal});
+		if(position != shard.index.end() && position->second.entry == entry) {
+			shard.index.erase(position);
+		}
+	}
+	shard.spare.splice(shard.spare.begin(), shard.entries, entry);
+}
+
+template <typename index_type, typename cost_type>
+const bool PathCache<index_type, cost_type>::lookup(Index path_begin, Index path_end, std::uint64_t version, std::vector<Index> &path, Cost &weight) {
+	Shard &shard = this->shard(path_end);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto position = shard.index.find(Key {path_begin, path_end});
+	if(position == shard.index.end()) {
+		return false;
+	}
+	const Link entry = position->second.entry;
+	const std::size_t offset = position->second.offset;
+	if(entry->version != version) {
+		drop(shard, entry);
+		return false;
+	}
+	shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+	path.assign(entry->path.begin() + offset, entry->path.end());
+	weight = entry->remaining[offset];
+	return true;
+}
+
+template <typename index_type, typename cost_type>
+void PathCache<index_type, cost_type>::insert(std::uint64_t version, const Index *path, const Cost *remaining, std::size_t length) {
+	if(length == 0) {
+		return;
+	}
+	const Index goal = path[length - 1];
+	Shard &shard = this->shard(goal);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto existing = shard.index.find(Key {path[0], goal});
+	if(existing != shard.index.end()) {
+		if(existing->second.entry->version == version) {
+			// Another search stored the path first, or it is the suffix of a cached path
+			return;
+		}
+		drop(shard, existing->second.entry);
+	}
+	if(shard.entries.size() >= capacity) {
+		drop(shard, std::prev(shard.entries.end()));
+	}
+	if(shard.spare.empty()) {
+		shard.spare.emplace_back();
+	}
+	shard.entries.splice(shard.entries.begin(), shard.spare, shard.spare.begin());
+	const Link entry = shard.entries.begin();
+	entry->version = version;
+	entry->path.assign(path, path + length);
+	entry->remaining.assign(remaining, remaining + length);
+	for(std::size_t offset = 0; offset < length; ++offset) {
+		shard.index[Key {path[offset], goal}] = Position {entry, offset};
+	}
+}
+
+template <typename index_type, typename cost_type>
+void PathCache<index_type, cost_type>::clear() {
+	for(auto shard = shards.begin(); shard != shards.end(); ++shard) {
+		std::lock_guard<std::mutex> lock((*shard)->mutex);
+		(*shard)->index.clear();
+		(*shard)->spare.splice((*shard)->spare.begin(), (*shard)->entries);
+	}
+}
+
+template <typename index_type, typename cost_type>
+const std::size_t PathCache<index_type, cost_type>::size() const {
+	std::size_t count {0};
+	for(auto shard = shards.begin(); shard != shards.end(); ++shard) {
+		std::lock_guard<std::mutex> lock((*shard)->mutex);
+		count += (*shard)->entries.size();
+	}
+	return count;
+}
+
+/**
+ * Search answering queries from a PathCache shared with other searches, and storing the paths it finds there.
+ *
+ * The graph has to count its changes through a version() member, see Grid::version, so paths found on
+ * older versions are not returned. Views of a graph forward its version, and a NodeGraph counts the changes
+ * reported through changed. On a jump point grid, only the jump points of a cached path are indexed.
+ *
+ * Constructed from the graph and the cache, so a BatchAStar of cached searches, created with the cache
+ * as an additional argument, shares one cache between all workers.
+ *
+ * Template parameters:
+ *   search_type: Search answering the misses, such as AStarSearch or GridAStar. Provides the search data
+ *                of the nodes on its path through state(id).
+ */
+template <typename search_type>
+class CachedSearch {
+public:
+	typedef search_type            Search;
+	typedef typename Search::Graph Graph;
+	typedef typename Search::Index Index;
+	typedef typename Search::Cost  Cost;
+	typedef typename Search::State State;
+	typedef PathCache<Index, Cost> Cache;
+	typedef typename std::vector<Index>::const_iterator PathIterator;
+	
+private:
+	/**
+	 * Detects if a graph type counts its changes through version().
+	 */
+	template <typename type>
+	struct Versioned {
+		template <typename graph>
+		static auto test(int) -> decltype(std::declval<const graph&>().version(), std::true_type());
+		template <typename>
+		static std::false_type test(...);
+		static const bool value = decltype(test<type>(0))::value;
+	};
+	
+	const Graph *graph;
+	Cache *cache;
+	Search search;
+	std::vector<Index> result {};
+	std::vector<Cost> remaining {};
+	Cost cost {0};
+	bool found {false};
+	bool hit {false};
+	
+public:
+	static_assert(Versioned<Graph>::value, "CachedSearch requires a graph_type counting its changes through version(), see Grid::version");
+	
+	CachedSearch(const Graph &graph, Cache &cache): graph(&graph), cache(&cache), search(graph) {}
+	
+	/**
+	 * Answers the query from @path_begin to @path_end from the cache, or searches it and caches the path found.
+	 * Returns if the target was reached.
+	 */
+	const bool query(Index path_begin, Index path_end);
+	
+	const bool successful() const {
+		return found;
+	}
+	const Cost weight() const {
+		return cost;
+	}
+	/**
+	 * Returns if the last query was answered by the cache.
+	 */
+	const bool cached() const {
+		return hit;
+	}
+	/**
+	 * The search answering the misses, holding the search data of the last query it answered.
+	 */
+	const Search &solver() const {
+		return search;
+	}
+	
+	const PathIterator begin() const {
+		return result.begin();
+	}
+	const PathIterator end() const {
+		return result.end();
+	}
+};
+
+template <typename search_type>
+const bool CachedSearch<search_type>::query(Index path_begin, Index path_end) {
+	const std::uint64_t current = graph->version();
+	hit = cache->lookup(path_begin, path_end, current, result, cost);
+	if(hit) {
+		return found = true;
+	}
+	found = search.query(path_begin, path_end);
+	cost = search.weight();
+	result.assign(search.begin(), search.end());
+	if(found) {
+		remaining.clear();
+		for(auto id = result.begin(); id != result.end(); ++id) {
+			remaining.push_back(cost - search.state(*id).g);
+		}
+		cache->insert(current, result.data(), remaining.data(), result.size());
+	}
+	return found;
+}
+
+#endif